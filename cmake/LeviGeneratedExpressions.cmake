@@ -0,0 +1,62 @@
+#.rst:
+# LeviGeneratedExpressions
+# ------------------------
+#
+# Build compiled expressions ahead of time and link them in a target::
+#
+#   levi_add_generated_expressions(<target>
+#                                  GENERATOR <executable>
+#                                  EXPRESSIONS <name> [<name> ...]
+#                                  [OUTPUT_DIRECTORY <directory>])
+#
+# The generator is an executable which sets the SourcesOnly compilation
+# backend, uses its first argument as generatedSourcesDirectory() and compiles
+# the expressions with the given names. Their sources are built as part of
+# <target>, and the expressions compiled with the same names in <target> are
+# used without building anything at runtime.
+#
+# OUTPUT_DIRECTORY defaults to ${CMAKE_CURRENT_BINARY_DIR}/<target>_levi.
+
+if(DEFINED __LEVI_GENERATED_EXPRESSIONS_INCLUDED)
+  return()
+endif()
+set(__LEVI_GENERATED_EXPRESSIONS_INCLUDED TRUE)
+
+function(levi_add_generated_expressions target)
+    set(options)
+    set(oneValueArgs GENERATOR OUTPUT_DIRECTORY)
+    set(multiValueArgs EXPRESSIONS)
+    cmake_parse_arguments(LEVI_GENERATED "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
+
+    if(NOT LEVI_GENERATED_GENERATOR)
+        message(FATAL_ERROR "levi_add_generated_expressions: GENERATOR is required.")
+    endif()
+
+    if(NOT LEVI_GENERATED_EXPRESSIONS)
+        message(FATAL_ERROR "levi_add_generated_expressions: EXPRESSIONS is required.")
+    endif()
+
+    if(NOT LEVI_GENERATED_OUTPUT_DIRECTORY)
+        set(LEVI_GENERATED_OUTPUT_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}/${target}_levi)
+    endif()
+
+    set(generatedSources)
+    foreach(expression ${LEVI_GENERATED_EXPRESSIONS})
+        list(APPEND generatedSources ${LEVI_GENERATED_OUTPUT_DIRECTORY}/${expression}/source.cpp)
+    endforeach()
+
+    if(TARGET ${LEVI_GENERATED_GENERATOR})
+        set(generatorCommand $<TARGET_FILE:${LEVI_GENERATED_GENERATOR}>)
+    else()
+        set(generatorCommand ${LEVI_GENERATED_GENERATOR})
+    endif()
+
+    add_custom_command(OUTPUT ${generatedSources}
+                       COMMAND ${CMAKE_COMMAND} -E make_directory ${LEVI_GENERATED_OUTPUT_DIRECTORY}
+                       COMMAND ${generatorCommand} ${LEVI_GENERATED_OUTPUT_DIRECTORY}
+                       DEPENDS ${LEVI_GENERATED_GENERATOR}
+                       COMMENT "Generating the levi expressions of ${target}"
+                       VERBATIM)
+
+    target_sources(${target} PRIVATE ${generatedSources})
+endfunction()
@@ -11,6 +11,10 @@
 #include <levi/ForwardDeclarations.h>
 #include <levi/AutogeneratedHelper.h>
 #include <levi/CompiledEvaluable.h>
+#include <levi/SqueezeEvaluable.h>
+#include <atomic>
+#include <future>
+#include <chrono>
 
 template<typename EvaluableT>
 class levi::AutogeneratedEvaluable
@@ -19,24 +23,31 @@ class levi::AutogeneratedEvaluable
 public:
 
     using SqueezedMatrix = typename levi::TreeComponent<EvaluableT>::SqueezedMatrix;
+    using BatchInput = typename levi::AutogeneratedHelper<EvaluableT>::BatchInput;
+    using value_type = typename EvaluableT::value_type;
+    using SqueezedMatrixRef = Eigen::Ref<SqueezedMatrix>;
+    using GenericsMatrixRef = typename levi::AutogeneratedHelper<EvaluableT>::GenericsMatrixRef;
+    using base_type = levi::CompiledEvaluable<GenericsMatrixRef, SqueezedMatrixRef>;
 
 private:
 
-    using SqueezedMatrixRef = Eigen::Ref<SqueezedMatrix>;
-    using base_type = levi::CompiledEvaluable<SqueezedMatrixRef, SqueezedMatrixRef>;
+    template <typename>
+    friend class levi::CompilationUnit;
 
     levi::ExpressionComponent<EvaluableT> m_fullExpression;
     levi::CompiledEvaluableFactory<base_type> m_compiledEvaluable;
 
     levi::AutogeneratedHelper<EvaluableT> m_helper;
+    std::vector<BatchInput> m_batchInputs;
+    Eigen::Index m_batchInputSize;
 
-public:
+    //Used in place of the compiled library until it is loaded
+    levi::ExpressionComponent<levi::SqueezeEvaluable<EvaluableT>> m_squeezed;
+    std::atomic<bool> m_isCompiled;
+    std::future<void> m_compilation; //Declared last, so that the compilation ends before the other members are destroyed
 
-    AutogeneratedEvaluable(const levi::ExpressionComponent<EvaluableT>& fullExpression, const std::string& name)
-        : levi::Evaluable<SqueezedMatrix> (fullExpression.rows(), fullExpression.cols(), name)
-          , m_fullExpression(fullExpression)
-          , m_helper({fullExpression}, name)
-    {
+    //Generates the header and the source of the compiled class
+    levi::GeneratedSources generateSources() {
         std::string cleanName = m_helper.name();
 
         std::ostringstream header;
@@ -47,33 +58,182 @@ public:
         header << "#include<levi/CompiledEvaluable.h>" << std::endl << std::endl;
         header << "class " << cleanName << ": public " << type_name<base_type>() << " {" <<std::endl;
         header << "public:" << std::endl;
-        header << "    virtual void evaluate(const std::vector<" << type_name<SqueezedMatrixRef>() << ">& generics, "
+        header << "    virtual void evaluate(const std::vector<" << type_name<GenericsMatrixRef>() << ">& generics, "
                << type_name<SqueezedMatrixRef>() << " output) final;" << std::endl;
+        header << "    virtual void evaluateBatch(const " << type_name<value_type>() << "* inputs, size_t inputStride, "
+               << type_name<value_type>() << "* outputs, size_t outputStride, size_t n) final;" << std::endl;
         header << "};" << std::endl;
         header << "#endif //LEVI_COMPILED"<< cleanName << "_H" << std::endl;
 
+        bool scalarized = m_helper.isScalarizable(levi::scalarizationMaximumSize());
+
         std::ostringstream cpp;
-        cpp << "void " << cleanName << "::evaluate(const std::vector<" << type_name<SqueezedMatrixRef>() << ">& generics, "
+        std::vector<std::string> kernelParts;
+        if (!scalarized) {
+            cpp << m_helper.getTypedKernel(cleanName + "Kernel");
+            kernelParts = m_helper.getTypedKernelParts(cleanName + "Kernel");
+        }
+        cpp << "void " << cleanName << "::evaluate(const std::vector<" << type_name<GenericsMatrixRef>() << ">& generics, "
             << type_name<SqueezedMatrixRef>() << " output) {" << std::endl;
-        cpp << m_helper.getHelpersDeclaration().str() << std::endl;
-        cpp << m_helper.getCommonsDeclaration().str() << std::endl;
-        if (this->rows() == 1 && this->cols() == 1) {
-            cpp << "    output(0, 0) = ";
-        } else {
-            cpp << "    output = ";
+        std::string body = scalarized ? m_helper.getScalarizedCode({"output"}) : m_helper.getTypedKernelCall(cleanName + "Kernel", {"output"});
+        cpp << body;
+        cpp << "}" << std::endl;
+
+        //The same code, looping over the samples of a batch
+        cpp << "void " << cleanName << "::evaluateBatch(const " << type_name<value_type>() << "* inputs, size_t inputStride, "
+            << type_name<value_type>() << "* outputs, size_t outputStride, size_t n) {" << std::endl;
+        cpp << m_helper.getBatchLoop(body, {"output"});
+        cpp << "}" << std::endl;
+
+        m_batchInputs = m_helper.batchInputs();
+        m_batchInputSize = 0;
+        for (const BatchInput& input : m_batchInputs) {
+            m_batchInputSize += input.rows * input.cols;
         }
-        cpp << m_helper.getFinalExpressions()[0].str() << ";" << std::endl << "}" << std::endl;
-
-        m_helper.compile(header.str(), cpp.str(), m_compiledEvaluable, cleanName);
 
         this->addDependencies(m_helper.getDependencies());
 
+        return {cleanName, header.str(), cpp.str(), kernelParts};
+    }
+
+    //Used by a CompilationUnit, once the library shared by the expressions of the unit has been loaded
+    void setCompiledInstance(base_type* instance, std::shared_ptr<void> sharedLibrary) {
+        m_compiledEvaluable.setSharedInstance(instance, sharedLibrary);
+        m_isCompiled.store(true, std::memory_order_release);
+    }
+
+public:
+
+    /**
+     * @brief Constructor
+     * @param fullExpression The expression to be compiled.
+     * @param name The name of the expression, used also for the generated library.
+     * @param options The profile used to build the library.
+     * @param asynchronous If true, the library is built and loaded on a background thread.
+     * In the meantime, the expression is evaluated by squeezing it. The compiled version is used as soon as it is loaded.
+     */
+    AutogeneratedEvaluable(const levi::ExpressionComponent<EvaluableT>& fullExpression, const std::string& name,
+                           const levi::CompileOptions& options = levi::CompileOptions(), bool asynchronous = false)
+        : levi::Evaluable<SqueezedMatrix> (fullExpression.rows(), fullExpression.cols(), name)
+          , m_fullExpression(fullExpression)
+          , m_helper({fullExpression}, name, options)
+          , m_isCompiled(false)
+    {
+        levi::GeneratedSources sources = generateSources();
+
+        if (asynchronous) {
+            m_squeezed = levi::ExpressionComponent<levi::SqueezeEvaluable<EvaluableT>>(fullExpression, name);
+
+            //The code has already been generated, the background thread only builds and loads the library
+            m_compilation = std::async(std::launch::async, [this, sources]() {
+                m_isCompiled.store(m_helper.compile(sources.header, sources.cpp, m_compiledEvaluable, sources.className, sources.kernelParts),
+                                   std::memory_order_release);
+            });
+        } else {
+            m_isCompiled = m_helper.compile(sources.header, sources.cpp, m_compiledEvaluable, sources.className, sources.kernelParts);
+
+            if (!m_isCompiled) { //Only the sources have been written, the expression is evaluated without compiling it
+                m_squeezed = levi::ExpressionComponent<levi::SqueezeEvaluable<EvaluableT>>(fullExpression, name);
+            }
+        }
+
+    }
+
+    /**
+     * @brief Constructor of an expression built in a CompilationUnit, together with the other expressions of the unit.
+     * @param sources Filled with the generated code, which is built by the unit.
+     *
+     * Until the unit is compiled, the expression is evaluated by squeezing it.
+     */
+    AutogeneratedEvaluable(const levi::ExpressionComponent<EvaluableT>& fullExpression, const std::string& name,
+                           const levi::CompileOptions& options, levi::GeneratedSources& sources)
+        : levi::Evaluable<SqueezedMatrix> (fullExpression.rows(), fullExpression.cols(), name)
+          , m_fullExpression(fullExpression)
+          , m_helper({fullExpression}, name, options)
+          , m_isCompiled(false)
+    {
+        sources = generateSources();
+        m_squeezed = levi::ExpressionComponent<levi::SqueezeEvaluable<EvaluableT>>(fullExpression, name);
     }
 
     ~AutogeneratedEvaluable();
 
+    /**
+     * @brief Whether the compiled library is loaded and used for the evaluation.
+     */
+    bool isReady() const {
+        return m_isCompiled.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Whether the compiled instance comes from a kernel linked ahead of time (see levi::KernelRegistry).
+     */
+    bool isLinked() const {
+        return isReady() && m_compiledEvaluable.isLinked();
+    }
+
+    /**
+     * @brief Blocks until the compiled library is loaded.
+     */
+    void waitUntilReady() {
+        if (m_compilation.valid()) {
+            m_compilation.wait();
+        }
+    }
+
+    /**
+     * @brief Blocks until the compiled library is loaded, or the timeout expires.
+     * @return True if the compiled library is loaded.
+     */
+    template<typename Rep, typename Period>
+    bool waitUntilReady(const std::chrono::duration<Rep, Period>& timeout) {
+        if (m_compilation.valid()) {
+            m_compilation.wait_for(timeout);
+        }
+        return isReady();
+    }
+
+    /**
+     * @brief The inputs of each sample of a batch, i.e. the generics of the compiled code. They are stacked column-major, in this order.
+     *
+     * Besides the variables, they include the nodes which are not supported by the code generation, like skew matrices.
+     */
+    const std::vector<BatchInput>& batchInputs() const {
+        return m_batchInputs;
+    }
+
+    /**
+     * @brief Evaluates the expression on n samples with a single call to the compiled library.
+     *
+     * Each input sample contains the values of batchInputs(). Each output sample contains the value of the expression, column-major.
+     * @param inputStride Distance between two consecutive input samples. If 0, the samples are contiguous.
+     * @param outputStride Distance between two consecutive output samples. If 0, the samples are contiguous.
+     */
+    void evaluateBatch(const value_type* inputs, value_type* outputs, size_t n, size_t inputStride = 0, size_t outputStride = 0) {
+        assert(isReady() && "The batched evaluation is available only once the compiled library is loaded.");
+
+        if (inputStride == 0) {
+            inputStride = static_cast<size_t>(m_batchInputSize);
+        }
+
+        if (outputStride == 0) {
+            outputStride = static_cast<size_t>(this->rows() * this->cols());
+        }
+
+        m_compiledEvaluable->evaluateBatch(inputs, inputStride, outputs, outputStride, n);
+    }
+
     virtual const SqueezedMatrix& evaluate() final {
 
+        if (!isReady()) {
+            this->m_evaluationBuffer = m_squeezed.evaluate();
+            return this->m_evaluationBuffer;
+        }
+
+        if (m_squeezed.isValidExpression()) {
+            m_squeezed = levi::ExpressionComponent<levi::SqueezeEvaluable<EvaluableT>>(); //not needed anymore
+        }
+
         m_compiledEvaluable->evaluate(m_helper.evaluateGenerics(), this->m_evaluationBuffer);
 
         return this->m_evaluationBuffer;
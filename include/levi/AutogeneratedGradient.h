@@ -0,0 +1,127 @@
+/*
+* Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+* Authors: Stefano Dafarra
+* CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+*
+*/
+#ifndef LEVI_AUTOGENERATEDGRADIENT_H
+#define LEVI_AUTOGENERATEDGRADIENT_H
+
+#include <levi/HelpersForwardDeclarations.h>
+#include <levi/ForwardDeclarations.h>
+#include <levi/AutogeneratedHelper.h>
+#include <levi/CompiledEvaluable.h>
+#include <levi/SqueezeEvaluable.h>
+
+/**
+ * @brief The compiled gradient of a scalar expression with respect to a variable, as a row vector (see getColumnDerivative).
+ *
+ * The generated code computes the expression and then accumulates the adjoints of its values backwards (reverse mode),
+ * so that its cost does not depend on the dimension of the variable. When the reverse mode is not available
+ * (see AutogeneratedHelper::isReverseModeAvailable), the symbolic derivative is compiled instead.
+ */
+template<typename EvaluableT>
+class levi::AutogeneratedGradient
+    : public levi::Evaluable<Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic>> {
+
+public:
+
+    using SqueezedMatrix = typename levi::TreeComponent<EvaluableT>::SqueezedMatrix;
+    using SqueezedMatrixRef = Eigen::Ref<SqueezedMatrix>;
+    using GenericsMatrixRef = typename levi::AutogeneratedHelper<EvaluableT>::GenericsMatrixRef;
+    using base_type = levi::CompiledEvaluable<GenericsMatrixRef, SqueezedMatrixRef>;
+
+private:
+
+    levi::CompiledEvaluableFactory<base_type> m_compiledEvaluable;
+    levi::AutogeneratedHelper<EvaluableT> m_helper;
+    bool m_isReverseMode;
+
+    //Used when the reverse mode is not available, or when only the sources have been written
+    levi::ExpressionComponent<levi::Evaluable<SqueezedMatrix>> m_fallback;
+
+public:
+
+    /**
+     * @brief Constructor
+     * @param fullExpression The scalar expression to be differentiated.
+     * @param variable The variable of interest.
+     * @param name The name of the gradient, used also for the generated library.
+     * @param options The profile used to build the library.
+     */
+    AutogeneratedGradient(const levi::ExpressionComponent<EvaluableT>& fullExpression, std::shared_ptr<levi::VariableBase> variable,
+                          const std::string& name, const levi::CompileOptions& options = levi::CompileOptions())
+        : levi::Evaluable<SqueezedMatrix>(1, variable->dimension(), name)
+          , m_helper({fullExpression}, name, options)
+          , m_isReverseMode(false)
+    {
+        assert((fullExpression.rows() == 1) && (fullExpression.cols() == 1) && "The gradient can be computed only for scalar expressions.");
+
+        if (!m_helper.isReverseModeAvailable(variable, levi::reverseModeMaximumSize())) {
+            std::cout << "The reverse mode is not available for " << name << ". The symbolic derivative is compiled instead." << std::endl;
+            m_fallback = fullExpression.getColumnDerivative(0, variable).compile(name, options);
+            this->addDependencies(m_fallback);
+            return;
+        }
+
+        std::string cleanName = m_helper.name();
+
+        std::ostringstream header;
+        header << "//This file has been autogenerated" << std::endl;
+        header << "#ifndef LEVI_COMPILED"<< cleanName << "_H" << std::endl;
+        header << "#define LEVI_COMPILED"<< cleanName << "_H" << std::endl;
+
+        header << "#include<levi/CompiledEvaluable.h>" << std::endl << std::endl;
+        header << "class " << cleanName << ": public " << type_name<base_type>() << " {" <<std::endl;
+        header << "public:" << std::endl;
+        header << "    virtual void evaluate(const std::vector<" << type_name<GenericsMatrixRef>() << ">& generics, "
+               << type_name<SqueezedMatrixRef>() << " output) final;" << std::endl;
+        header << "};" << std::endl;
+        header << "#endif //LEVI_COMPILED"<< cleanName << "_H" << std::endl;
+
+        std::ostringstream cpp;
+        cpp << "void " << cleanName << "::evaluate(const std::vector<" << type_name<GenericsMatrixRef>() << ">& generics, "
+            << type_name<SqueezedMatrixRef>() << " output) {" << std::endl;
+        cpp << m_helper.getScalarizedGradientCode(variable, "output");
+        cpp << "}" << std::endl;
+
+        this->addDependencies(m_helper.getDependencies());
+
+        m_isReverseMode = m_helper.compile(header.str(), cpp.str(), m_compiledEvaluable, cleanName);
+
+        if (!m_isReverseMode) { //Only the sources have been written
+            m_fallback = fullExpression.getColumnDerivative(0, variable).squeeze(name);
+        }
+    }
+
+    ~AutogeneratedGradient();
+
+    /**
+     * @brief Whether the gradient is computed by the code generated with the reverse mode.
+     */
+    bool isReverseMode() const {
+        return m_isReverseMode;
+    }
+
+    const levi::CompilationTimings& compilationTimings() const {
+        return m_helper.compilationTimings();
+    }
+
+    virtual const SqueezedMatrix& evaluate() final {
+
+        if (!m_isReverseMode) {
+            this->m_evaluationBuffer = m_fallback.evaluate();
+            return this->m_evaluationBuffer;
+        }
+
+        m_compiledEvaluable->evaluate(m_helper.evaluateGenerics(), this->m_evaluationBuffer);
+
+        return this->m_evaluationBuffer;
+    }
+
+};
+
+template<typename EvaluableT>
+levi::AutogeneratedGradient<EvaluableT>::~AutogeneratedGradient() { }
+
+#endif // LEVI_AUTOGENERATEDGRADIENT_H
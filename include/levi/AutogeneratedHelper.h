@@ -13,15 +13,27 @@
 #include <levi/TreeExpander.h>
 #include <levi/Expression.h>
 #include <levi/autogenerated/Path.h>
+#include <levi/CompilationCache.h>
+#include <levi/CompilationBackend.h>
+#include <levi/CompileOptions.h>
+#include <levi/KernelRegistry.h>
 
 #include <levi/external/zupply.h>
 #include <shlibpp/SharedLibraryClass.h>
 #include <shlibpp/SharedLibrary.h>
 
 #include <ostream>
+#include <new>
 #include <cstdlib>
+#include <iomanip>
+#include <limits>
 
 #include <fstream>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <unordered_set>
 
 //Taken from https://stackoverflow.com/questions/81870/is-it-possible-to-print-a-variables-type-in-standard-c
 class static_string
@@ -77,6 +89,16 @@ namespace levi {
 
     template <typename BaseType>
     class CompiledEvaluableFactory;
+
+    /**
+     * @brief The sources of a compiled class, to be built together with other ones (see CompilationUnit).
+     */
+    struct GeneratedSources {
+        std::string className;
+        std::string header;
+        std::string cpp;
+        std::vector<std::string> kernelParts;
+    };
 }
 
 template <typename BaseType>
@@ -87,20 +109,47 @@ class levi::CompiledEvaluableFactory {
 
     BaseType* m_compiledEvaluable;
     shlibpp::SharedLibraryClassFactory<BaseType> m_compiledEvaluableFactory;
+    bool m_isLinked; //The instance has been created from a kernel in the KernelRegistry
+    std::shared_ptr<void> m_sharedLibrary; //Keeps loaded the library which created the instance, when it is shared with other instances
 
 public:
 
     CompiledEvaluableFactory()
         : m_compiledEvaluable(nullptr)
+          , m_isLinked(false)
     {}
 
     ~CompiledEvaluableFactory() {
         if (m_compiledEvaluable) {
-            m_compiledEvaluableFactory.destroy(m_compiledEvaluable);
+            if (m_isLinked || m_sharedLibrary) {
+                delete m_compiledEvaluable;
+            } else {
+                m_compiledEvaluableFactory.destroy(m_compiledEvaluable);
+            }
             m_compiledEvaluable = nullptr;
         }
     }
 
+    /**
+     * @brief Whether the compiled instance comes from a kernel generated ahead of time and linked in the executable.
+     */
+    bool isLinked() const {
+        return m_isLinked;
+    }
+
+    bool isValid() const {
+        return m_compiledEvaluable != nullptr;
+    }
+
+    /**
+     * @brief Uses an instance created by a library shared with other instances, which is kept loaded until the instance is deleted.
+     */
+    void setSharedInstance(BaseType* instance, std::shared_ptr<void> sharedLibrary) {
+        assert(!m_compiledEvaluable && "The instance has already been set.");
+        m_compiledEvaluable = instance;
+        m_sharedLibrary = sharedLibrary;
+    }
+
     BaseType* operator->() const {
         return m_compiledEvaluable;
     }
@@ -112,6 +161,17 @@ public:
 
     using SqueezedMatrix = typename levi::TreeComponent<EvaluableT>::SqueezedMatrix;
     using SqueezedMatrixRef = Eigen::Ref<SqueezedMatrix>;
+    using GenericsMatrixRef = Eigen::Ref<const SqueezedMatrix>;
+
+    /**
+     * @brief A generic in the samples of a batch. Its elements are stored column-major, starting from offset.
+     */
+    struct BatchInput {
+        std::string name;
+        Eigen::Index rows;
+        Eigen::Index cols;
+        Eigen::Index offset;
+    };
 
 private:
 
@@ -121,32 +181,34 @@ private:
         std::string literal;
         bool isScalar = false;
         bool isAlreadyCompressed = false;
-        bool isSimple = false;
     };
 
-    struct CommonSubExp {
+    struct ConstantDeclaration {
+        std::string name;
+        std::string values; //Column-major, separated by commas
+    };
+
+    struct TemporaryDeclaration {
+        std::string type;
         std::string name;
         std::string expression;
-        std::string declaration;
-        bool active = true;
+        bool isScalar;
     };
 
     std::string m_cleanName;
     std::string m_workingDirectory;
+    levi::CompilationTimings m_timings;
+    levi::CompileOptions m_options;
     std::vector<LiteralComponent> m_literalSubExpressions;
     std::vector<levi::TreeComponent<EvaluableT>> m_expandedExpression;
     std::vector<size_t> m_generics;
     std::vector<size_t> m_finalExpressionIndices;
-    std::unordered_map<std::string, std::vector<int>> m_helpersMap;
-    std::vector<CommonSubExp> m_helpers;
-    std::ostringstream m_helpersDeclarations;
-    std::vector<CommonSubExp> m_commonExpressions;
-    std::ostringstream m_commonDeclarations;
+    std::vector<ConstantDeclaration> m_constants;
+    std::vector<TemporaryDeclaration> m_temporaries; //In the order in which they have to be computed
     std::vector<std::ostringstream> m_finalExpressions;
-    std::string m_genericsName, m_helpersName, m_commonsName;
-    std::unordered_map<std::string, std::vector<int>> m_commonsMap;
+    std::string m_genericsName, m_helpersName, m_commonsName, m_constantsName;
 
-    std::vector<SqueezedMatrixRef> m_genericsRefs;
+    std::vector<GenericsMatrixRef> m_genericsRefs;
 
     void expandElement(int i) {
         Type type;
@@ -162,46 +224,81 @@ private:
 
         type = subExpr.type;
 
-        if (type == Type::Sum) {
+        if (type == Type::Null) {
+
+            literalSubExpr.literal = nullaryLiteral(subExpr.rows(), subExpr.cols(), "Zero", 0);
+            literalSubExpr.isScalar = (subExpr.rows() == 1) && (subExpr.cols() == 1);
+
+
+        } else if (type == Type::Identity) {
+
+            literalSubExpr.literal = nullaryLiteral(subExpr.rows(), subExpr.cols(), "Identity", 1);
+            literalSubExpr.isScalar = (subExpr.rows() == 1) && (subExpr.cols() == 1);
+
+
+        } else if (type == Type::Constant) {
+
+            if ((subExpr.rows() == 1) && (subExpr.cols() == 1)) {
+                literalSubExpr.literal = scalarLiteral(subExpr.buffer(0, 0));
+                literalSubExpr.isScalar = true;
+            } else {
+                //The values are stored column-major in a static array, initialized at compile time
+                std::string name = m_constantsName + std::to_string(i) + "_";
+                std::ostringstream values;
+                for (Eigen::Index element = 0; element < subExpr.buffer.size(); ++element) {
+                    values << ((element > 0) ? ((element % 8) ? ", " : ",\n        ") : "") << scalarLiteral(subExpr.buffer.data()[element]);
+                }
+                m_constants.push_back({name, values.str()});
+
+                literalSubExpr.literal = "Eigen::Map<const " + matrixType(subExpr.rows(), subExpr.cols()) + ">(" + name + ", " +
+                        std::to_string(subExpr.rows()) + ", " + std::to_string(subExpr.cols()) + ")";
+                literalSubExpr.isScalar = false;
+            }
+
+
+        } else if ((type == Type::Horzcat) || (type == Type::Vertcat)) {
+
+            //The comma initializer writes each operand directly in its block of the result
+            literalSubExpr.literal = "(" + newMatrix(subExpr.rows(), subExpr.cols()) + " << " + lhs.literal + ", " + rhs.literal + ").finished()";
+            literalSubExpr.isScalar = false;
+
+
+        } else if (type == Type::Sum) {
 
             literalSubExpr.literal = "(" + lhs.literal + " + " + rhs.literal + ")";
 
             literalSubExpr.isScalar = (lhs.isScalar && rhs.isScalar);
-            literalSubExpr.isSimple = false;
 
         } else if (type == Type::Subtraction) {
 
             literalSubExpr.literal = "(" + lhs.literal + " - " + rhs.literal + ")";
             literalSubExpr.isScalar = (lhs.isScalar && rhs.isScalar);
-            literalSubExpr.isSimple = false;
 
 
         } else if (type == Type::Product) {
 
             literalSubExpr.literal = lhs.literal + " * " + rhs.literal;
             literalSubExpr.isScalar = (lhs.isScalar && rhs.isScalar);
-            literalSubExpr.isSimple = false;
 
 
         } else if (type == Type::Division) {
 
             literalSubExpr.literal = lhs.literal + " / " + rhs.literal;
             literalSubExpr.isScalar = lhs.isScalar;
-            literalSubExpr.isSimple = false;
 
 
         } else if (type == Type::InvertedSign) {
 
             literalSubExpr.literal = "-" + lhs.literal;
             literalSubExpr.isScalar = lhs.isScalar;
-            literalSubExpr.isSimple = false;
 
 
         } else if (type == Type::Pow) {
 
-            literalSubExpr.literal = "std::pow(" + lhs.literal +", " + std::to_string(subExpr.exponent) + ")";
+            std::ostringstream power;
+            power << "levi::power<" << type_name<typename EvaluableT::value_type>() << ">(" << lhs.literal << ", " << scalarLiteral(subExpr.exponent) << ")";
+            literalSubExpr.literal = power.str();
             literalSubExpr.isScalar = true;
-            literalSubExpr.isSimple = false;
 
 
         } else if (type == Type::Transpose) {
@@ -209,7 +306,6 @@ private:
             assert(!lhs.isScalar);
             literalSubExpr.literal = "(" + lhs.literal + ").transpose()";
             literalSubExpr.isScalar = false;
-            literalSubExpr.isSimple = true;
 
 
         } else if (type == Type::Row) {
@@ -220,11 +316,9 @@ private:
                 literalSubExpr.literal = "(" + lhs.literal + ")(" + std::to_string(subExpr.block.startRow) + ", 0)";
                 subExpr.type = Type::Element;
                 literalSubExpr.isScalar = true;
-                literalSubExpr.isSimple = true;
             } else {
                 literalSubExpr.literal = "(" + lhs.literal + ").row(" + std::to_string(subExpr.block.startRow) + ")";
                 literalSubExpr.isScalar = false;
-                literalSubExpr.isSimple = true;
             }
         } else if (type == Type::Column) {
 
@@ -234,11 +328,9 @@ private:
                 literalSubExpr.literal = "(" + lhs.literal + ")(0, " + std::to_string(subExpr.block.startCol) + ")";
                 subExpr.type = Type::Element;
                 literalSubExpr.isScalar = true;
-                literalSubExpr.isSimple = true;
             } else {
                 literalSubExpr.literal = "(" + lhs.literal + ").col(" + std::to_string(subExpr.block.startCol) + ")";
                 literalSubExpr.isScalar = false;
-                literalSubExpr.isSimple = true;
             }
 
         } else if (type == Type::Element) {
@@ -246,7 +338,6 @@ private:
             assert(!lhs.isScalar);
             literalSubExpr.literal = "(" + lhs.literal + ")(" + std::to_string(subExpr.block.startRow) + ", " + std::to_string(subExpr.block.startCol) + ")";
             literalSubExpr.isScalar = true;
-            literalSubExpr.isSimple = true;
 
 
         } else if (type == Type::Block) {
@@ -254,7 +345,6 @@ private:
             assert(!lhs.isScalar);
             literalSubExpr.literal = "(" + lhs.literal + ").block<" + std::to_string(subExpr.block.rows) + ", " + std::to_string(subExpr.block.cols) + ">(" + std::to_string(subExpr.block.startRow) + ", " + std::to_string(subExpr.block.startCol) + ")";
             literalSubExpr.isScalar = false;
-            literalSubExpr.isSimple = true;
 
 
         }
@@ -266,372 +356,466 @@ private:
     }
 
 
-    void getScalarVariables() {
+    void splitExpression(const std::string& expression, std::ostringstream& output) {
+        size_t offset = 0;
+        size_t currentindex = 0;
+        int lastStopCharachter = -1;
 
-        for(int index = 0; index < m_expandedExpression.size(); ++index) {
+        while (currentindex < expression.size()) {
 
-            if (!m_literalSubExpressions[index].isScalar || m_literalSubExpressions[index].isAlreadyCompressed ||
-                m_literalSubExpressions[index].isSimple) {
-                continue;
+            if (expression[currentindex] == '+' || expression[currentindex] == '-' || expression[currentindex] == '*') {
+                lastStopCharachter = currentindex;
             }
 
-            std::vector<int>& helpers = m_helpersMap[m_literalSubExpressions[index].literal];
-
-            if (helpers.size() > 1) {
-                CommonSubExp newHelper;
-                newHelper.name = m_helpersName + std::to_string(m_helpers.size()) + "_";
-                newHelper.expression = m_literalSubExpressions[index].literal;
-                std::ostringstream decl;
-                decl << "    " << type_name<typename EvaluableT::value_type>() << " " << newHelper.name << " = ";
-                newHelper.declaration = decl.str();
-
-                for (int& i : helpers) {
-                    m_literalSubExpressions[i].literal = newHelper.name;
-                    m_literalSubExpressions[i].isAlreadyCompressed = true;
-                }
-
-                m_helpers.push_back(newHelper);
+            if (lastStopCharachter > 0 && (currentindex - offset) > 150) {
+                output << expression.substr(offset, (static_cast<size_t>(lastStopCharachter) - offset + 1)) << std::endl << "       ";
+                offset = static_cast<size_t>(lastStopCharachter) + 1;
+                lastStopCharachter = -1;
             }
-        }
-    }
 
-    void getCommonSubExpression() {
-
-        for(int index = 0; index < m_expandedExpression.size(); ++index) {
+            ++currentindex;
 
-            if (m_literalSubExpressions[index].isAlreadyCompressed || m_literalSubExpressions[index].isSimple) {
-                continue;
-            }
+        }
 
-            std::vector<int>& commons = m_commonsMap[m_literalSubExpressions[index].literal];
+        output << expression.substr(offset, currentindex - offset);
+    }
 
-            if (commons.size() > 1) {
-                CommonSubExp newCommon;
-                newCommon.name = m_commonsName + std::to_string(m_commonExpressions.size()) + "_";
-                newCommon.expression = m_literalSubExpressions[index].literal;
-                std::ostringstream decl;
-                decl << "    Eigen::Matrix<" << type_name<typename EvaluableT::value_type>() << ", "
-                     << std::to_string(m_expandedExpression[index].rows()) << ", "
-                     << std::to_string(m_expandedExpression[index].cols()) << "> "
-                     << newCommon.name << " = ";
-                newCommon.declaration = decl.str();
 
-                for (int& i : commons) {
-                    m_literalSubExpressions[i].literal = newCommon.name;
-                    m_literalSubExpressions[i].isAlreadyCompressed = true;
-                }
+    //Matrices with more elements have dynamic dimensions in the generated code, since fixed-size ones are allocated on the stack
+    static constexpr Eigen::Index maximumFixedSize = 256;
 
-                m_commonExpressions.push_back(newCommon);
-            }
+    static std::string matrixType(Eigen::Index rows, Eigen::Index cols) {
+        std::ostringstream type;
+        type << "Eigen::Matrix<" << type_name<typename EvaluableT::value_type>() << ", ";
+        if (rows * cols > maximumFixedSize) {
+            type << "Eigen::Dynamic, Eigen::Dynamic>";
+        } else {
+            type << rows << ", " << cols << ">";
         }
+        return type.str();
     }
 
-    void cleanHelpers() {
+    static std::string mapType(Eigen::Index rows, Eigen::Index cols, bool isConst) {
+        return "Eigen::Map<" + std::string(isConst ? "const " : "") + matrixType(rows, cols) + ", 0, Eigen::OuterStride<>>";
+    }
 
-        for (int i = m_helpers.size() - 1; i >= 0; --i) {
+    //A new matrix, to be filled with a comma initializer
+    static std::string newMatrix(Eigen::Index rows, Eigen::Index cols) {
+        if (rows * cols > maximumFixedSize) {
+            return matrixType(rows, cols) + "(" + std::to_string(rows) + ", " + std::to_string(cols) + ")";
+        }
+        return matrixType(rows, cols) + "()";
+    }
 
-            bool isInFinal = false;
-            for (const size_t& finals : m_finalExpressionIndices) {
-                std::string& final = m_literalSubExpressions[finals].literal;
-                isInFinal = isInFinal || final.find(m_helpers[i].name) != std::string::npos;
-            }
+    //The strength reduction of levi::power, written explicitly. The base is repeated, hence it has to be a variable or a literal.
+    static std::string powerCode(const std::string& base, typename EvaluableT::value_type exponent) {
+        using Scalar = typename EvaluableT::value_type;
 
-            std::vector<std::pair<int, size_t>> inclusions;
+        if (exponent == Scalar(0.5)) {
+            return "std::sqrt(" + base + ")";
+        }
 
-            for (int other = i + 1; other < m_helpers.size(); ++other) { //Check if the current helper was present in a subexpression previously checked
-                if (m_helpers[other].active && (m_helpers[other].expression.size() > m_helpers[i].expression.size())) {
-                    size_t offset = m_helpers[other].expression.find(m_helpers[i].expression);
-                    if (offset != std::string::npos) {
-                        inclusions.emplace_back(other, offset);
-                    }
-                }
-            }
+        if (exponent == Scalar(-0.5)) {
+            return scalarLiteral(1) + " / std::sqrt(" + base + ")";
+        }
 
-            if (isInFinal) {
-                for (auto& other: inclusions) {
-                    m_helpers[other.first].expression.replace(other.second, m_helpers[i].expression.size(), m_helpers[i].name);
-                }
-            } else {
-                if (inclusions.size() > 1) {
-                    for (auto& other: inclusions) {
-                        m_helpers[other.first].expression.replace(other.second, m_helpers[i].expression.size(), m_helpers[i].name);
-                    }
-                } else {
-                    for (int deactivatedHelper : m_helpersMap[m_helpers[i].expression]) {
-                        m_literalSubExpressions[deactivatedHelper].literal = m_helpers[i].expression; //restore the original expression in the deleted helper
-                    }
-                    m_helpers[i].active = false;
-                }
+        Scalar absoluteExponent = std::abs(exponent);
+        if ((absoluteExponent <= Scalar(4)) && (absoluteExponent == std::floor(absoluteExponent))) {
+            if (absoluteExponent == Scalar(0)) {
+                return scalarLiteral(1);
             }
-        }
 
-        for (auto& helper :m_helpers) {
-            if (helper.active) {
-                m_helpersDeclarations << helper.declaration << helper.expression << ";" << std::endl;
+            std::string product = base;
+            for (int i = 1; i < static_cast<int>(absoluteExponent); ++i) {
+                product += " * " + base;
             }
+            return (exponent < 0) ? scalarLiteral(1) + " / (" + product + ")" : product;
         }
 
+        return "std::pow(" + base + ", " + scalarLiteral(exponent) + ")";
     }
 
-    void cleanCommonSubExpressions() {
-
-        for (int i = m_commonExpressions.size() - 1; i >= 0; --i) {
+    //A floating point literal with all the digits needed to represent the value exactly. Negative values are in parentheses.
+    static std::string scalarLiteral(typename EvaluableT::value_type value) {
+        std::ostringstream literal;
+        literal << std::setprecision(std::numeric_limits<typename EvaluableT::value_type>::max_digits10);
 
-            bool isInFinal = false;
-            for (const size_t& finals : m_finalExpressionIndices) {
-                std::string& final = m_literalSubExpressions[finals].literal;
-                isInFinal = isInFinal || final.find(m_commonExpressions[i].name) != std::string::npos;
-            }
-
-            std::vector<std::pair<int, size_t>> inclusions;
-
-            for (int other = i + 1; other < m_commonExpressions.size(); ++other) { //Check if the current subexpression was present in a subexpression previously checked
-                if (m_commonExpressions[other].active && (m_commonExpressions[other].expression.size() > m_commonExpressions[i].expression.size())) {
-                    size_t offset = m_commonExpressions[other].expression.find(m_commonExpressions[i].expression);
-                    if (offset != std::string::npos) {
-                        inclusions.emplace_back(other, offset);
-                    }
-                }
-            }
-
-            if (isInFinal) {
-                for (auto& other: inclusions) {
-                    m_commonExpressions[other.first].expression.replace(other.second, m_commonExpressions[i].expression.size(), m_commonExpressions[i].name);
-                }
-            } else {
-                if (inclusions.size() > 1) {
-                    for (auto& other: inclusions) {
-                        m_commonExpressions[other.first].expression.replace(other.second, m_commonExpressions[i].expression.size(), m_commonExpressions[i].name);
-                    }
-                } else {
-                    m_commonExpressions[i].active = false;
-                }
-            }
+        if (std::isnan(value)) {
+            literal << "std::numeric_limits<" << type_name<typename EvaluableT::value_type>() << ">::quiet_NaN()";
+            return literal.str();
         }
 
-        for (auto& common :m_commonExpressions) {
-            if (common.active) {
-                m_commonDeclarations << common.declaration << common.expression << ";" << std::endl;
+        if (std::isinf(value)) {
+            literal << "std::numeric_limits<" << type_name<typename EvaluableT::value_type>() << ">::infinity()";
+        } else {
+            literal << std::abs(value);
+            if (literal.str().find_first_of(".e") == std::string::npos) {
+                literal << ".0";
             }
         }
 
+        return std::signbit(value) ? "(-" + literal.str() + ")" : literal.str();
     }
 
-
-    void splitExpression(const std::string& expression, std::ostringstream& output) {
-        size_t offset = 0;
-        size_t currentindex = 0;
-        int lastStopCharachter = -1;
-
-        while (currentindex < expression.size()) {
-
-            if (expression[currentindex] == '+' || expression[currentindex] == '-' || expression[currentindex] == '*') {
-                lastStopCharachter = currentindex;
-            }
-
-            if (lastStopCharachter > 0 && (currentindex - offset) > 150) {
-                output << expression.substr(offset, (static_cast<size_t>(lastStopCharachter) - offset + 1)) << std::endl << "       ";
-                offset = static_cast<size_t>(lastStopCharachter) + 1;
-                lastStopCharachter = -1;
-            }
-
-            ++currentindex;
-
+    //Zero or identity matrices. The 1x1 case is a scalar literal.
+    static std::string nullaryLiteral(Eigen::Index rows, Eigen::Index cols, const std::string& function, typename EvaluableT::value_type scalarValue) {
+        if ((rows == 1) && (cols == 1)) {
+            return scalarLiteral(scalarValue);
         }
+        return matrixType(rows, cols) + "::" + function + "(" + std::to_string(rows) + ", " + std::to_string(cols) + ")";
+    }
 
-        output << expression.substr(offset, currentindex - offset);
+    static bool isAccessor(Type type) {
+        return (type == Type::Transpose) || (type == Type::Row) || (type == Type::Column) || (type == Type::Element) || (type == Type::Block);
     }
 
+    //Literals longer than this are stored in a temporary, so that the code of a component never grows with the depth of the tree
+    static constexpr size_t maximumInlinedLength = 1000;
 
     void getLiteralExpression() {
         m_literalSubExpressions.resize(m_expandedExpression.size());
-        m_helpersMap.clear();
 
         std::cout << "Expanding generics.." << std::endl;
 
-
         for (size_t generic = 0; generic < m_generics.size(); ++generic) {
             if (m_expandedExpression[m_generics[generic]].rows() == 1 && m_expandedExpression[m_generics[generic]].cols() == 1) {
-                m_literalSubExpressions[m_generics[generic]].literal = m_genericsName + "[" + std::to_string(generic) + "](0,0)";
+                m_literalSubExpressions[m_generics[generic]].literal = m_genericsName + std::to_string(generic) + "(0,0)";
                 m_literalSubExpressions[m_generics[generic]].isScalar = true;
-                m_literalSubExpressions[m_generics[generic]].isSimple = true;
             } else {
-                m_literalSubExpressions[m_generics[generic]].literal = m_genericsName + "[" + std::to_string(generic) + "]";
+                m_literalSubExpressions[m_generics[generic]].literal = m_genericsName + std::to_string(generic);
                 m_literalSubExpressions[m_generics[generic]].isScalar = false;
             }
         }
 
-        std::cout << "First tree expansion.." << std::endl;
+        std::cout << "Counting uses.." << std::endl;
 
-        for(int i = 0; i < m_expandedExpression.size(); ++i) {
+        //The tree has a single node for each evaluable, hence common subexpressions are shared nodes.
+        //Visiting from the outputs, count how many copies of each literal the code would contain if inlined.
+        //Components which would be copied more than once are stored in a temporary. Accessors are always inlined.
+        std::vector<size_t> copies(m_expandedExpression.size(), 0), remainingParents(m_expandedExpression.size(), 0);
+        std::vector<bool> isTemporary(m_expandedExpression.size(), false), isFinal(m_expandedExpression.size(), false);
 
-            expandElement(i);
+        for (size_t final : m_finalExpressionIndices) {
+            copies[final]++;
+            isFinal[final] = true;
+        }
 
-            LiteralComponent& literalSubExpr = m_literalSubExpressions[static_cast<size_t>(i)];
+        for (size_t i = m_expandedExpression.size(); i-- > 0;) {
+            const levi::TreeComponent<EvaluableT>& subExpr = m_expandedExpression[i];
 
-            m_helpersMap[literalSubExpr.literal].push_back(i);
-        }
+            if ((subExpr.type == Type::Generic) || (copies[i] == 0)) {
+                continue;
+            }
 
-        std::cout << "Getting helpers.." << std::endl;
+            if (subExpr.isLeaf()) {
+                continue; //Null, Identity and Constant are literals without operands
+            }
 
-        getScalarVariables();
+            isTemporary[i] = !isAccessor(subExpr.type) && (copies[i] > 1);
+            size_t inlinedCopies = isTemporary[i] ? 1 : copies[i];
 
-        std::cout << "Second tree expansion.." << std::endl;
+            copies[subExpr.lhsIndex] += inlinedCopies;
+            remainingParents[subExpr.lhsIndex]++;
 
-        for(int i = 0; i < m_expandedExpression.size(); ++i) {
-            expandElement(i); //some inner elements may have been modified when extracting the helpers. Here we reconstruct the total expression
+            if (subExpr.isBinary()) {
+                copies[subExpr.rhsIndex] += inlinedCopies;
+                remainingParents[subExpr.rhsIndex]++;
+            }
         }
 
-        std::cout << "Cleaning helpers.." << std::endl;
+        std::cout << "Generating code.." << std::endl;
 
-        cleanHelpers(); //remove helpers that turned out to be useless;
+        size_t numberOfHelpers = 0, numberOfCommons = 0;
 
-        std::cout << "Third tree expansion.." << std::endl;
+        for (size_t i = 0; i < m_expandedExpression.size(); ++i) {
+            levi::TreeComponent<EvaluableT>& subExpr = m_expandedExpression[i];
+            LiteralComponent& literalSubExpr = m_literalSubExpressions[i];
 
-        for(int i = 0; i < m_expandedExpression.size(); ++i) {
-            levi::TreeComponent<EvaluableT>& subExpr = m_expandedExpression[static_cast<size_t>(i)];
-            LiteralComponent& literalSubExpr = m_literalSubExpressions[static_cast<size_t>(i)];
+            if ((subExpr.type == Type::Generic) || (copies[i] == 0)) {
+                continue;
+            }
 
-            expandElement(i); //some inner elements may have been modified when extracting the helpers. Here we reconstruct the total expression
+            expandElement(static_cast<int>(i));
 
-            m_commonsMap[literalSubExpr.literal].push_back(i);
-        }
+            if (subExpr.isLeaf()) {
+                continue;
+            }
 
-        std::cout << "Getting common subexpressions.." << std::endl;
+            //The literal of the operands is not needed anymore once all their parents have been expanded
+            std::vector<size_t> operands(1, subExpr.lhsIndex);
+            if (subExpr.isBinary()) {
+                operands.push_back(subExpr.rhsIndex);
+            }
 
-        getCommonSubExpression(); //check if some subexpressions are duplicated
+            for (size_t operand : operands) {
+                remainingParents[operand]--;
+                if (!remainingParents[operand] && !isFinal[operand] && (m_expandedExpression[operand].type != Type::Generic)) {
+                    std::string().swap(m_literalSubExpressions[operand].literal);
+                }
+            }
 
-        std::cout << "Fourth tree expansion.." << std::endl;
+            if (!isTemporary[i] && (isAccessor(subExpr.type) || (literalSubExpr.literal.size() <= maximumInlinedLength))) {
+                continue;
+            }
 
-        for(int i = 0; i < m_expandedExpression.size(); ++i) {
-            expandElement(i); //some inner elements may have been modified when extracting the common subexpressions. Here we reconstruct the total expression
-        }
+            TemporaryDeclaration temporary;
+            temporary.isScalar = literalSubExpr.isScalar;
+            if (literalSubExpr.isScalar) {
+                temporary.name = m_helpersName + std::to_string(numberOfHelpers++) + "_";
+                std::ostringstream scalarType;
+                scalarType << type_name<typename EvaluableT::value_type>();
+                temporary.type = scalarType.str();
+            } else {
+                temporary.name = m_commonsName + std::to_string(numberOfCommons++) + "_";
+                temporary.type = matrixType(subExpr.rows(), subExpr.cols());
+            }
 
-        std::cout << "Cleaning common subexpressions.." << std::endl;
+            std::ostringstream expression;
+            splitExpression(literalSubExpr.literal, expression);
+            temporary.expression = expression.str();
 
-        cleanCommonSubExpressions(); //remove common subexpressions that turned out to be useless;
+            literalSubExpr.literal = temporary.name;
+            m_temporaries.push_back(std::move(temporary));
+            literalSubExpr.isAlreadyCompressed = true;
+        }
 
         for (size_t final = 0; final < m_finalExpressionIndices.size(); ++final) {
-
-            std::cout << "Adding new lines.." << std::endl;
-
             splitExpression(m_literalSubExpressions[m_finalExpressionIndices[final]].literal, m_finalExpressions[final]); //add some newlines where needed
         }
 
     }
 
-public:
+    static std::string readFile(const std::string& fileName) {
+        std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+        if (!file.is_open()) {
+            return "";
+        }
+        std::ostringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
 
-    AutogeneratedHelper() { }
+    static std::string libraryDirectory(const std::string& buildDirectory) {
+#ifdef _MSC_VER
+        return buildDirectory + "\\build\\lib\\Release";
+#else
+        return buildDirectory + "/build/lib";
+#endif
+    }
 
-    AutogeneratedHelper(const std::vector<levi::ExpressionComponent<EvaluableT>>& fullExpressions, const std::string& name)
-    {
-        m_genericsName = "generics";
-        m_helpersName = "m_helper";
-        m_commonsName = "m_common";
+    static double elapsedMilliseconds(const std::chrono::steady_clock::time_point& begin) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count()/1000.0;
+    }
 
-        setExpressions(fullExpressions, name);
+    static std::string libraryFileName(const std::string& directory, const std::string& libraryName) {
+#ifdef __APPLE__
+        return libraryDirectory(directory) + "/lib" + libraryName + ".dylib";
+#else
+        return libraryDirectory(directory) + "/lib" + libraryName + ".so";
+#endif
     }
 
-    void setVariablesName(const std::string& genericsName = "generics", const std::string& helpersName = "m_helper",
-                          const std::string& commonsName = "m_common") {
-        m_genericsName = genericsName;
-        m_helpersName = helpersName;
-        m_commonsName = commonsName;
+    std::string compilerFlags() const {
+        std::string flags = "-std=c++14 -fPIC " + m_options.flags();
+
+        std::string includeDirectories = LEVI_AUTOGENERATED_INCLUDE_DIRS;
+        size_t begin = 0;
+        while (begin < includeDirectories.size()) {
+            size_t end = std::min(includeDirectories.find(';', begin), includeDirectories.size());
+            if (end > begin) {
+                flags += " -I\"" + includeDirectories.substr(begin, end - begin) + "\"";
+            }
+            begin = end + 1;
+        }
+
+        const char* userFlags = std::getenv("CXXFLAGS");
+        if (userFlags) {
+            flags += " " + std::string(userFlags);
+        }
+
+        return flags;
     }
 
-    void setExpressions(const std::vector<levi::ExpressionComponent<EvaluableT>>& fullExpressions, const std::string& name) {
+    //The content of the levi headers in the precompiled header. It changes when levi is updated, and the precompiled header has to be rebuilt.
+    static std::string precompiledLeviHeaders() {
+        std::string includeDirectories = LEVI_AUTOGENERATED_INCLUDE_DIRS;
+        std::string leviDirectory = includeDirectories.substr(0, includeDirectories.find(';')) + "/levi/";
+        std::string content;
+        for (const char* header : {"CompiledEvaluable.h", "ForwardDeclarations.h", "HelpersForwardDeclarations.h"}) {
+            content += readFile(leviDirectory + header);
+        }
+        return content;
+    }
 
-        for (const auto& expressions : fullExpressions) {
-            std::cout << "Expanding expression.." << std::endl;
-            m_finalExpressionIndices.emplace_back(levi::expandTree(expressions, false, m_expandedExpression, m_generics));
+    //Returns the header to be included in order to use the precompiled header, or an empty string if it is not available.
+    //The precompiled header depends on the flags and on the levi headers, hence it is stored in a folder named after them.
+    std::string precompiledHeader(const std::string& flags) {
+        std::string root = levi::compilationCacheDirectory().size() ? levi::compilationCacheDirectory() : zz::os::current_working_directory();
+        std::string directory = root + "/levi-pch-" + levi::ContentHash().add(LEVI_CXX_COMPILER).add(flags).add(precompiledLeviHeaders()).hex();
+        std::string headerName = directory + "/levi_pch.h";
+        std::string compilerId = LEVI_CXX_COMPILER_ID;
+        std::string precompiledName = headerName + ((compilerId == "GNU") ? ".gch" : ".pch");
+
+        if (zz::os::is_file(precompiledName)) {
+            return headerName;
         }
-        m_finalExpressions.resize(m_finalExpressionIndices.size());
-        getLiteralExpression();
 
-        m_cleanName = name;
+        std::cout << "Building the precompiled header.." << std::endl;
 
-        for (char& letter : m_cleanName) {
-            if (letter == ' ') {
-                letter = '_';
-            } else if (!(((letter >= 'a') && (letter <= 'z')) || ((letter >= 'A') && (letter <= 'Z')) || ((letter >= '0') && (letter <= '9')))) {
-                letter = '-';
-            }
+        if (!zz::os::create_directory_recursive(directory)) {
+            return "";
         }
 
-        for (size_t generic : m_generics) {
-            m_genericsRefs.emplace_back(m_expandedExpression[generic].buffer);
+        std::fstream header(headerName.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+        header << "#include <Eigen/Core>" << std::endl;
+        header << "#include <levi/CompiledEvaluable.h>" << std::endl;
+        header.close();
+
+        //Built with a temporary name, so that concurrent processes never use an incomplete file
+        std::random_device randomDevice;
+        std::string temporaryName = precompiledName + ".tmp" + std::to_string(zz::os::thread_id()) + "-" + std::to_string(randomDevice());
+        std::string command = "\"" + std::string(LEVI_CXX_COMPILER) + "\" " + flags + " -x c++-header \"" + headerName + "\" -o \"" + temporaryName + "\"";
+
+        if (std::system(command.c_str()) != EXIT_SUCCESS || !zz::os::rename(temporaryName, precompiledName)) {
+            std::cout << "Unable to build the precompiled header." << std::endl;
+            zz::os::remove_file(temporaryName);
+            return "";
         }
+
+        return headerName;
     }
 
-    bool setWorkingDirectory(std::string workingDirectory) {
-        zz::fs::Path dir(workingDirectory);
-        if (!dir.exist()) {
-            bool dirCreated = zz::os::create_directory(workingDirectory);
+    static std::string partSourceName(size_t part) {
+        return "sourcePart" + std::to_string(part) + ".cpp";
+    }
 
-            if (dirCreated) {
-                m_workingDirectory = workingDirectory;
-                return true;
-            }
+    //Writes the sources to be built ahead of time. The compiled class is added to the KernelRegistry when the executable starts.
+    //The parts of a split kernel are included in source.cpp, so that the build system does not need to know how many they are.
+    void writeGeneratedSources(const std::string& headerContent, const std::string& cppContent, const std::vector<std::string>& partsContent,
+                               static_string baseClassName, const std::string& className, const std::string& signature) {
+        std::string directory = levi::generatedSourcesDirectory() + "/" + m_cleanName;
 
-            return false;
+        std::cout << "Writing the sources in " << directory << std::endl;
+
+        bool dirCreated = zz::os::create_directory_recursive(directory);
+        assert(dirCreated && "Unable to create the directory of the generated sources.");
+        levi::unused(dirCreated);
+
+        std::fstream header((directory + "/source.h").c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+        assert(header.is_open());
+        header << headerContent;
+        header.close();
+
+        std::fstream cpp((directory + "/source.cpp").c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+        assert(cpp.is_open());
+        cpp << "//This file has been autogenerated" << std::endl;
+        cpp << "#include <levi/KernelRegistry.h>" << std::endl;
+        cpp << "#include \"source.h\" " << std::endl;
+        cpp << "typedef " << baseClassName << " base_type;" << std::endl;
+        cpp << "namespace {" << std::endl;
+        cpp << "levi::KernelRegistrar<base_type, " << className << "> " << className << "Registrar(\"" << m_cleanName << "\", \"" << signature << "\");" << std::endl;
+        cpp << "}" << std::endl << std::endl;
+        cpp << cppContent;
+
+        for (size_t part = 0; part < partsContent.size(); ++part) {
+            std::fstream partFile((directory + "/" + partSourceName(part)).c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+            assert(partFile.is_open());
+            partFile << partsContent[part];
+            cpp << "#include \"" << partSourceName(part) << "\"" << std::endl;
         }
-        m_workingDirectory = workingDirectory;
-        return true;
+
+        cpp.close();
     }
 
-    const std::string& name() {
-        return m_cleanName;
+    //Runs the commands with at most one process for each hardware thread. Returns true if all of them succeeded.
+    static bool runConcurrently(const std::vector<std::string>& commands) {
+        std::atomic<size_t> next(0);
+        std::atomic<bool> success(true);
+        size_t numberOfWorkers = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), commands.size());
+
+        std::vector<std::thread> workers;
+        for (size_t worker = 0; worker < numberOfWorkers; ++worker) {
+            workers.emplace_back([&commands, &next, &success]() {
+                for (size_t command = next++; command < commands.size(); command = next++) {
+                    if (std::system(commands[command].c_str()) != EXIT_SUCCESS) {
+                        success = false;
+                    }
+                }
+            });
+        }
+
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        return success;
     }
 
-    template <typename BaseClass>
-    void compile(const std::string& headerContent, const std::string& cppContent,
-                 levi::CompiledEvaluableFactory<BaseClass>& baseClassFactory,
-                 const std::string& className) {
+    //Invokes directly the compiler used to build levi. Returns false if the compilation failed.
+    bool buildWithCompiler(const std::string& directory, size_t numberOfParts) {
+        std::string flags = compilerFlags();
 
-        if (!m_workingDirectory.size()) {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        std::string pchHeader = precompiledHeader(flags);
+        m_timings.precompiledHeader = elapsedMilliseconds(begin);
 
-            std::cout << "Creating directory " << zz::os::current_working_directory() + "/" + m_cleanName << std::endl;
+        bool dirCreated = zz::os::create_directory_recursive(libraryDirectory(directory));
+        assert(dirCreated);
+        levi::unused(dirCreated);
 
-            bool dirCreated = setWorkingDirectory(zz::os::current_working_directory() + "/" + m_cleanName);
-            assert(dirCreated);
+        std::string libraryFile = libraryFileName(directory, m_cleanName + "Lib");
+        zz::os::remove_file(libraryFile);
+
+        std::string command = "\"" + std::string(LEVI_CXX_COMPILER) + "\" " + flags;
+
+        if (pchHeader.size()) {
+            command += " -include \"" + pchHeader + "\"";
         }
 
-        std::string leviListDir = LEVI_AUTOGENERATED_DIR;
+        std::string linkOptions = " -o \"" + libraryFile + "\"";
+#ifdef __APPLE__
+        linkOptions += " -undefined dynamic_lookup"; //shlibpp symbols are resolved when loading the library
+#endif
 
-        std::string CMakeSource = leviListDir + "/CMakeLists.auto";
-        std::string CMakeDest = m_workingDirectory + "/CMakeLists.txt";
+        std::cout << "Building.." << std::endl;
 
-        std::cout << "Copying CMakeLists.." << std::endl;
+        begin = std::chrono::steady_clock::now();
+        bool success;
 
-        zz::os::copyfile(CMakeSource, CMakeDest);
+        if (numberOfParts == 0) {
+            success = std::system((command + " -shared \"" + directory + "/source.cpp\"" + linkOptions).c_str()) == EXIT_SUCCESS;
+        } else {
+            //The parts of a split kernel are compiled concurrently, and then linked together
+            std::vector<std::string> sources(1, directory + "/source.cpp"), compileCommands;
+            for (size_t part = 0; part < numberOfParts; ++part) {
+                sources.push_back(directory + "/" + partSourceName(part));
+            }
 
-        std::string headerName = m_workingDirectory + "/source.h";
+            std::string linkCommand = "\"" + std::string(LEVI_CXX_COMPILER) + "\" " + flags + " -shared";
+            for (const std::string& source : sources) {
+                compileCommands.push_back(command + " -c \"" + source + "\" -o \"" + source + ".o\"");
+                linkCommand += " \"" + source + ".o\"";
+            }
 
-        std::cout << "Adding header.." << std::endl;
+            success = runConcurrently(compileCommands) && (std::system((linkCommand + linkOptions).c_str()) == EXIT_SUCCESS);
+        }
 
-        std::fstream header(headerName.c_str(), std::ios::out | std::ios::trunc);
+        m_timings.building = elapsedMilliseconds(begin);
 
-        assert(header.is_open());
-        header << headerContent;
-        header.close();
+        return success && zz::os::is_file(libraryFile);
+    }
 
-        std::string cppName = m_workingDirectory + "/source.cpp";
+    void buildWithCMake(const std::string& directory) {
+        std::string leviListDir = LEVI_AUTOGENERATED_DIR;
 
-        std::cout << "Adding cpp.." << std::endl;
+        std::string CMakeSource = leviListDir + "/CMakeLists.auto";
+        std::string CMakeDest = directory + "/CMakeLists.txt";
 
-        std::fstream cpp(cppName.c_str(), std::ios::out | std::ios::trunc);
-        assert(cpp.is_open());
+        std::cout << "Copying CMakeLists.." << std::endl;
 
-        cpp << "//This file has been autogenerated" << std::endl;
-        cpp << "#include <shlibpp/SharedLibraryClass.h>" << std::endl;
-        cpp << "#include \"source.h\" " << std::endl;
-        cpp << "typedef " << type_name<BaseClass>() << " base_type;" << std::endl;
-        cpp << "SHLIBPP_DEFINE_SHARED_SUBCLASS(" << className << "Factory, "  << className <<", base_type);"  << std::endl << std::endl;
-        cpp << cppContent;
-        cpp.close();
+        zz::os::copyfile(CMakeSource, CMakeDest);
 
-        std::string buildDir = m_workingDirectory + "/build";
+        std::string buildDir = directory + "/build";
         zz::fs::Path buildDirPath(buildDir);
         if (!buildDirPath.exist()) {
             bool dirCreated = zz::os::create_directory(buildDir);
@@ -644,6 +828,8 @@ public:
 #endif
         }
 
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
         std::cout << "Check Ninja availability" << std::endl;
 
         std::string check_ninja = "ninja --version";
@@ -658,7 +844,7 @@ public:
 
         std::cout << "Configuring Cmake.." << std::endl;
 
-        std::string buildCommand = "cmake -B" + buildDir + " -H" + m_workingDirectory;
+        std::string buildCommand = "cmake -B" + buildDir + " -H" + directory + " -DCMAKE_CXX_FLAGS_RELEASE=\"" + m_options.flags() + "\"";
 
         if (ninjaAvailable) {
             buildCommand = buildCommand + " -G Ninja";
@@ -667,18 +853,23 @@ public:
         ret = std::system(buildCommand.c_str());
         assert(ret == EXIT_SUCCESS && "The cmake configuration failed");
 
+        m_timings.configuration = elapsedMilliseconds(begin);
+
         std::cout << "Building.." << std::endl;
 
-        buildCommand = "cmake --build " + buildDir + " --config Release";
+        begin = std::chrono::steady_clock::now();
+
+        buildCommand = "cmake --build " + buildDir + " --config Release --parallel " + std::to_string(std::max(std::thread::hardware_concurrency(), 1u));
 
         ret = std::system(buildCommand.c_str());
         assert(ret == EXIT_SUCCESS && "The compilation failed");
 
 #ifdef _MSC_VER
-        zz::fs::Path libDir(buildDir + "\\lib\\Release", true);
+        zz::fs::Path libDir(libraryDirectory(directory), true);
 #else
-        zz::fs::Path libDir(buildDir + "/lib");
+        zz::fs::Path libDir(libraryDirectory(directory));
 #endif
+
         size_t attempts = 0;
         while (!(libDir.is_dir() && !libDir.empty()) && attempts < 1e6) {
             attempts++;
@@ -688,27 +879,407 @@ public:
             std::this_thread::sleep_for(5us);
         }
 
-        shlibpp::SharedLibraryClassFactory<BaseClass>& shlibFactory = baseClassFactory.m_compiledEvaluableFactory;
+        m_timings.building = elapsedMilliseconds(begin);
+    }
 
-        shlibFactory.extendSearchPath(buildDir + "\\lib\\Release");
-        shlibFactory.extendSearchPath(buildDir + "/lib");
+    //Writes the sources in the directory and builds them. Returns the directory containing the library.
+    std::string buildLibrary(const std::string& directory, const std::string& headerContent, const std::string& cppContent,
+                             const std::vector<std::string>& partsContent) {
 
-        std::cout << "Opening new library.." << std::endl;
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
-        bool isLibOpen = shlibFactory.open((m_cleanName + "Lib").c_str(), (className + "Factory").c_str());
+        std::string headerName = directory + "/source.h";
 
-        assert(isLibOpen && shlibFactory.isValid() && "Unable to open compiled shared library.");
+        std::cout << "Adding header.." << std::endl;
+
+        std::fstream header(headerName.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+
+        assert(header.is_open());
+        header << headerContent;
+        header.close();
+
+        std::string cppName = directory + "/source.cpp";
+
+        std::cout << "Adding cpp.." << std::endl;
+
+        std::fstream cpp(cppName.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+        assert(cpp.is_open());
+        cpp << cppContent;
+        cpp.close();
+
+        for (size_t part = 0; part < partsContent.size(); ++part) {
+            std::fstream partFile((directory + "/" + partSourceName(part)).c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+            assert(partFile.is_open());
+            partFile << partsContent[part];
+        }
+
+        //Parts of a previous build in the same directory would be built by CMake
+        for (size_t part = partsContent.size(); zz::os::is_file(directory + "/" + partSourceName(part)); ++part) {
+            zz::os::remove_file(directory + "/" + partSourceName(part));
+        }
+
+        m_timings.writingSources = elapsedMilliseconds(begin);
+
+        bool built = false;
+
+        if (levi::compilationBackend() == levi::CompilationBackend::Compiler) {
+            built = buildWithCompiler(directory, partsContent.size());
+
+            if (!built) {
+                std::cout << "The direct compilation failed. Using CMake instead." << std::endl;
+            }
+        }
+
+        if (!built) {
+            buildWithCMake(directory);
+        }
+
+        return libraryDirectory(directory);
+    }
+
+    //A cache entry is valid if it has been completed and it has been generated from the same sources
+    bool isValidCacheEntry(const std::string& entry, const std::string& headerContent, const std::string& cppContent,
+                           const std::vector<std::string>& partsContent) const {
+        std::string sourceDirectory = entry + "/" + m_cleanName;
+        bool valid = zz::os::is_file(entry + "/complete") && (readFile(sourceDirectory + "/source.h") == headerContent) &&
+                (readFile(sourceDirectory + "/source.cpp") == cppContent);
+
+        for (size_t part = 0; valid && (part < partsContent.size()); ++part) {
+            valid = (readFile(sourceDirectory + "/" + partSourceName(part)) == partsContent[part]);
+        }
+
+        return valid;
+    }
+
+    //Looks for a library compiled from the same sources in the cache, building it if not available. Returns the directory containing the library.
+    std::string compileInCache(const std::string& cacheDirectory, const std::string& headerContent, const std::string& cppContent,
+                               const std::vector<std::string>& partsContent) {
+        levi::ContentHash hash;
+        hash.add(headerContent).add(cppContent);
+        for (const std::string& part : partsContent) {
+            hash.add(part);
+        }
+        std::string key = hash.add(readFile(std::string(LEVI_AUTOGENERATED_DIR) + "/CMakeLists.auto")).add(levi::compilerSignature()).add(m_options.flags())
+                .add(levi::compilationBackend() == levi::CompilationBackend::Compiler ? LEVI_CXX_COMPILER : "cmake").hex();
+        std::string entry = cacheDirectory + "/" + m_cleanName + "-" + key;
+
+        //The sources are stored in a subfolder, since the name of the library is taken from the name of its folder
+        if (isValidCacheEntry(entry, headerContent, cppContent, partsContent)) {
+            std::cout << "Using cached library in " << entry << std::endl;
+            return libraryDirectory(entry + "/" + m_cleanName);
+        }
+
+        std::cout << "Compiling in cache entry " << entry << std::endl;
+
+        bool dirCreated = zz::os::create_directory_recursive(cacheDirectory);
+        assert(dirCreated && "Unable to create the cache directory.");
+        levi::unused(dirCreated);
+
+        //The library is built in a private directory and then moved atomically in the cache,
+        //so that concurrent processes never see an incomplete entry.
+        std::random_device randomDevice;
+        std::string temporaryEntry = entry + ".tmp" + std::to_string(zz::os::thread_id()) + "-" + std::to_string(randomDevice());
+
+        dirCreated = zz::os::create_directory(temporaryEntry) && zz::os::create_directory(temporaryEntry + "/" + m_cleanName);
+        assert(dirCreated && "Unable to create a temporary directory in the cache.");
+
+        buildLibrary(temporaryEntry + "/" + m_cleanName, headerContent, cppContent, partsContent);
+
+        std::fstream completeFile((temporaryEntry + "/complete").c_str(), std::ios::out | std::ios::trunc);
+        completeFile << key << std::endl;
+        completeFile.close();
+
+        if (!zz::os::rename(temporaryEntry, entry)) {
+            //Another process published the same entry in the meantime
+            zz::os::remove_dir(temporaryEntry);
+            assert(isValidCacheEntry(entry, headerContent, cppContent, partsContent) && "Unable to store the compiled library in the cache.");
+        }
+
+        return libraryDirectory(entry + "/" + m_cleanName);
+    }
+
+    //The typed generics followed by the typed outputs
+    std::string kernelParameters() const {
+        std::ostringstream parameters;
+        std::string separator = "";
+        for (size_t generic = 0; generic < m_generics.size(); ++generic) {
+            const levi::TreeComponent<EvaluableT>& component = m_expandedExpression[m_generics[generic]];
+            parameters << separator << mapType(component.rows(), component.cols(), true) << " " << m_genericsName << generic;
+            separator = ",\n        ";
+        }
+
+        for (size_t output = 0; output < m_finalExpressionIndices.size(); ++output) {
+            const levi::TreeComponent<EvaluableT>& component = m_expandedExpression[m_finalExpressionIndices[output]];
+            parameters << separator << mapType(component.rows(), component.cols(), false) << " output" << output;
+            separator = ",\n        ";
+        }
+        return parameters.str();
+    }
+
+    std::string kernelArguments() const {
+        std::string arguments, separator = "";
+        for (size_t generic = 0; generic < m_generics.size(); ++generic) {
+            arguments += separator + m_genericsName + std::to_string(generic);
+            separator = ", ";
+        }
+        for (size_t output = 0; output < m_finalExpressionIndices.size(); ++output) {
+            arguments += separator + "output" + std::to_string(output);
+            separator = ", ";
+        }
+        return arguments;
+    }
+
+    std::string finalAssignments() const {
+        std::ostringstream assignments;
+        for (size_t output = 0; output < m_finalExpressionIndices.size(); ++output) {
+            const levi::TreeComponent<EvaluableT>& component = m_expandedExpression[m_finalExpressionIndices[output]];
+            assignments << "    output" << output << ((component.rows() == 1 && component.cols() == 1) ? "(0, 0) = " : " = ")
+                        << m_finalExpressions[output].str() << ";" << std::endl;
+        }
+        return assignments.str();
+    }
+
+    //Ranges of temporaries computed by each part of the kernel, balanced according to the size of their code
+    std::vector<std::pair<size_t, size_t>> kernelPartition() const {
+        size_t totalSize = 0;
+        for (const TemporaryDeclaration& temporary : m_temporaries) {
+            totalSize += temporary.expression.size();
+        }
+        for (const std::ostringstream& final : m_finalExpressions) {
+            totalSize += final.str().size();
+        }
+
+        size_t maximumSize = levi::kernelPartMaximumSize();
+        size_t numberOfParts = maximumSize ? std::max<size_t>((totalSize + maximumSize - 1) / maximumSize, 1) : 1;
+        size_t partSize = totalSize / numberOfParts;
+
+        std::vector<std::pair<size_t, size_t>> parts;
+        size_t begin = 0, currentSize = 0;
+        for (size_t t = 0; t < m_temporaries.size(); ++t) {
+            currentSize += m_temporaries[t].expression.size();
+            if ((currentSize >= partSize) && (parts.size() + 1 < numberOfParts)) {
+                parts.emplace_back(begin, t + 1);
+                begin = t + 1;
+                currentSize = 0;
+            }
+        }
+        parts.emplace_back(begin, m_temporaries.size());
+
+        return parts;
+    }
+
+    //The structure storing the temporaries of a split kernel. Its member functions are the parts of the kernel.
+    //It is guarded, since the parts may be included in the same source.
+    std::string scratchDefinition(const std::string& kernelName, size_t numberOfParts) const {
+        std::ostringstream definition;
+        definition << "#ifndef LEVI_SCRATCH_" << kernelName << std::endl;
+        definition << "#define LEVI_SCRATCH_" << kernelName << std::endl;
+        definition << "struct " << kernelName << "Scratch {" << std::endl;
+        definition << "    EIGEN_MAKE_ALIGNED_OPERATOR_NEW" << std::endl;
+
+        for (const ConstantDeclaration& constant : m_constants) {
+            definition << "    static const " << type_name<typename EvaluableT::value_type>() << " " << constant.name << "[];" << std::endl;
+        }
+
+        for (const TemporaryDeclaration& temporary : m_temporaries) {
+            definition << "    " << temporary.type << " " << temporary.name << ";" << std::endl;
+        }
+
+        for (size_t part = 0; part < numberOfParts; ++part) {
+            definition << "    void part" << part << "(" << kernelParameters() << ");" << std::endl;
+        }
+
+        definition << "};" << std::endl;
+        definition << "#endif" << std::endl << std::endl;
+
+        return definition.str();
+    }
+
+public:
+
+    AutogeneratedHelper() { }
+
+    AutogeneratedHelper(const std::vector<levi::ExpressionComponent<EvaluableT>>& fullExpressions, const std::string& name,
+                        const levi::CompileOptions& options = levi::CompileOptions())
+    {
+        m_genericsName = "generics";
+        m_helpersName = "m_helper";
+        m_commonsName = "m_common";
+        m_constantsName = "m_constant";
+
+        setExpressions(fullExpressions, name, options);
+    }
+
+    void setVariablesName(const std::string& genericsName = "generics", const std::string& helpersName = "m_helper",
+                          const std::string& commonsName = "m_common", const std::string& constantsName = "m_constant") {
+        m_genericsName = genericsName;
+        m_helpersName = helpersName;
+        m_commonsName = commonsName;
+        m_constantsName = constantsName;
+    }
+
+    /**
+     * @brief Generates the code of the expressions.
+     * @param fullExpressions The expressions to be compiled together.
+     * @param name The name of the library. A non-default profile is appended to it.
+     * @param options The profile used to build the library.
+     */
+    void setExpressions(const std::vector<levi::ExpressionComponent<EvaluableT>>& fullExpressions, const std::string& name,
+                        const levi::CompileOptions& options = levi::CompileOptions()) {
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+        levi::AddedExpressions alreadyAdded;
+
+        for (const auto& expressions : fullExpressions) {
+            std::cout << "Expanding expression.." << std::endl;
+            m_finalExpressionIndices.emplace_back(levi::expandTree(expressions, false, m_expandedExpression, m_generics, alreadyAdded));
+        }
+        m_finalExpressions.resize(m_finalExpressionIndices.size());
+        getLiteralExpression();
+
+        m_options = options;
+        m_cleanName = name;
+
+        if (!options.isDefault()) {
+            m_cleanName += "_" + options.profileName();
+        }
+
+        for (char& letter : m_cleanName) {
+            if (letter == ' ') {
+                letter = '_';
+            } else if (!(((letter >= 'a') && (letter <= 'z')) || ((letter >= 'A') && (letter <= 'Z')) || ((letter >= '0') && (letter <= '9')) || (letter == '_'))) {
+                letter = '-';
+            }
+        }
+
+        for (size_t generic : m_generics) {
+            m_genericsRefs.emplace_back(m_expandedExpression[generic].buffer);
+        }
+
+        m_timings.codeGeneration = elapsedMilliseconds(begin);
+    }
+
+    bool setWorkingDirectory(std::string workingDirectory) {
+        zz::fs::Path dir(workingDirectory);
+        if (!dir.exist()) {
+            bool dirCreated = zz::os::create_directory(workingDirectory);
+
+            if (dirCreated) {
+                m_workingDirectory = workingDirectory;
+                return true;
+            }
+
+            return false;
+        }
+        m_workingDirectory = workingDirectory;
+        return true;
+    }
+
+    const std::string& name() {
+        return m_cleanName;
+    }
+
+    /**
+     * @brief Builds and loads the library.
+     * @param headerContent The header declaring the compiled class.
+     * @param cppContent The definition of the compiled class.
+     * @param baseClassFactory The factory where the compiled instance is created.
+     * @param className The name of the compiled class.
+     * @param partsContent The sources of the parts of a split kernel (see getTypedKernelParts), built in parallel.
+     * @return True if the compiled instance has been created. It is false only with the SourcesOnly backend.
+     *
+     * If a kernel with the same name and generated from the same code is in the KernelRegistry, it is used without building anything.
+     */
+    template <typename BaseClass>
+    bool compile(const std::string& headerContent, const std::string& cppContent,
+                 levi::CompiledEvaluableFactory<BaseClass>& baseClassFactory,
+                 const std::string& className, const std::vector<std::string>& partsContent = std::vector<std::string>()) {
+
+        levi::ContentHash signatureHash;
+        signatureHash.add(headerContent).add(cppContent);
+        for (const std::string& part : partsContent) {
+            signatureHash.add(part);
+        }
+        std::string signature = signatureHash.hex();
+
+        const typename levi::KernelRegistry<BaseClass>::Entry* linkedKernel = levi::KernelRegistry<BaseClass>::find(m_cleanName);
+
+        if (linkedKernel && (linkedKernel->signature == signature)) {
+            std::cout << "Using the kernel " << m_cleanName << " linked ahead of time." << std::endl;
+            baseClassFactory.m_compiledEvaluable = linkedKernel->create();
+            baseClassFactory.m_isLinked = true;
+            return true;
+        }
+
+        if (linkedKernel) {
+            std::cout << "The kernel " << m_cleanName << " linked ahead of time has been generated from a different expression. It is generated again." << std::endl;
+        }
+
+        if (levi::compilationBackend() == levi::CompilationBackend::SourcesOnly) {
+            writeGeneratedSources(headerContent, cppContent, partsContent, type_name<BaseClass>(), className, signature);
+            return false;
+        }
+
+        std::ostringstream cpp;
+        cpp << "//This file has been autogenerated" << std::endl;
+        cpp << "#include <shlibpp/SharedLibraryClass.h>" << std::endl;
+        cpp << "#include \"source.h\" " << std::endl;
+        cpp << "typedef " << type_name<BaseClass>() << " base_type;" << std::endl;
+        cpp << "SHLIBPP_DEFINE_SHARED_SUBCLASS(" << className << "Factory, "  << className <<", base_type);"  << std::endl << std::endl;
+        cpp << cppContent;
+
+        std::string libraryDirectory;
+        std::string cacheDirectory = levi::compilationCacheDirectory();
+
+        if (cacheDirectory.size()) {
+            libraryDirectory = compileInCache(cacheDirectory, headerContent, cpp.str(), partsContent);
+        } else {
+            if (!m_workingDirectory.size()) {
+
+                std::cout << "Creating directory " << zz::os::current_working_directory() + "/" + m_cleanName << std::endl;
+
+                bool dirCreated = setWorkingDirectory(zz::os::current_working_directory() + "/" + m_cleanName);
+                assert(dirCreated);
+            }
+
+            libraryDirectory = buildLibrary(m_workingDirectory, headerContent, cpp.str(), partsContent);
+        }
+
+        shlibpp::SharedLibraryClassFactory<BaseClass>& shlibFactory = baseClassFactory.m_compiledEvaluableFactory;
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+        shlibFactory.extendSearchPath(libraryDirectory);
+
+        std::cout << "Opening new library.." << std::endl;
+
+        bool isLibOpen = shlibFactory.open((m_cleanName + "Lib").c_str(), (className + "Factory").c_str());
+
+        assert(isLibOpen && shlibFactory.isValid() && "Unable to open compiled shared library.");
 
         baseClassFactory.m_compiledEvaluable = shlibFactory.create();
 
         assert(baseClassFactory.m_compiledEvaluable != nullptr && "The compiled instance is not valid.");
 
+        m_timings.loading = elapsedMilliseconds(begin);
+
         std::cout << "Automatic generation completed!" << std::endl;
+        std::cout << "Compilation timings (ms): " << m_timings << std::endl;
+
+        return true;
     }
 
-    const std::vector<SqueezedMatrixRef>& evaluateGenerics() {
-        for (size_t generic : m_generics) {
-            m_expandedExpression[generic].buffer = m_expandedExpression[generic].partialExpression.evaluate();
+    const levi::CompilationTimings& compilationTimings() const {
+        return m_timings;
+    }
+
+    const std::vector<GenericsMatrixRef>& evaluateGenerics() {
+        for (size_t i = 0; i < m_generics.size(); ++i) {
+            const SqueezedMatrix& genericValue = m_expandedExpression[m_generics[i]].partialExpression.evaluate();
+            //Rebind the reference to the evaluation buffer of the generic, avoiding any copy
+            m_genericsRefs[i].~GenericsMatrixRef();
+            new (&m_genericsRefs[i]) GenericsMatrixRef(genericValue);
         }
 
         return m_genericsRefs;
@@ -723,18 +1294,593 @@ public:
         return deps;
     }
 
-    const std::ostringstream& getHelpersDeclaration() const {
-        return m_helpersDeclarations;
+    /**
+     * @brief Declaration of the static arrays storing the values of the constant matrices.
+     */
+    std::string getConstantsDeclaration() const {
+        std::ostringstream declaration;
+        for (const ConstantDeclaration& constant : m_constants) {
+            declaration << "    static const " << type_name<typename EvaluableT::value_type>() << " " << constant.name << "[] = {" << constant.values << "};" << std::endl;
+        }
+        return declaration.str();
     }
 
-    const std::ostringstream& getCommonsDeclaration() const {
-        return m_commonDeclarations;
+    /**
+     * @brief Declaration of the temporaries used by the final expressions, in the order in which they have to be computed.
+     */
+    std::string getTemporariesDeclaration() const {
+        std::ostringstream declaration;
+        for (const TemporaryDeclaration& temporary : m_temporaries) {
+            declaration << "    " << temporary.type << " " << temporary.name << " = " << temporary.expression << ";" << std::endl;
+        }
+        return declaration.str();
     }
 
     const std::vector<std::ostringstream>& getFinalExpressions() const {
         return m_finalExpressions;
     }
 
+    /**
+     * @brief Function computing the expressions with Eigen, where generics and outputs are typed with their dimensions.
+     *
+     * The parameters are the generics, named after the generics name followed by their index, and then the outputs,
+     * named "output" followed by their index. The function is visible only in the generated library.
+     * If the kernel is split in parts (see getTypedKernelParts), the function calls them in sequence, while the
+     * definition of the scratch structure, holding the temporaries, precedes the function.
+     */
+    std::string getTypedKernel(const std::string& kernelName) const {
+        std::vector<std::pair<size_t, size_t>> parts = kernelPartition();
+        std::string scratchName = kernelName + "Scratch";
+
+        std::ostringstream kernel;
+
+        if (parts.size() > 1) {
+            kernel << scratchDefinition(kernelName, parts.size());
+            for (const ConstantDeclaration& constant : m_constants) {
+                kernel << "const " << type_name<typename EvaluableT::value_type>() << " " << scratchName << "::" << constant.name
+                       << "[] = {" << constant.values << "};" << std::endl;
+            }
+            kernel << std::endl;
+        }
+
+        kernel << "namespace {" << std::endl;
+        kernel << "void " << kernelName << "(" << kernelParameters() << ") {" << std::endl;
+
+        if (parts.size() > 1) {
+            //Allocated once for each thread, since it may be too large for the stack
+            kernel << "    static thread_local std::unique_ptr<" << scratchName << "> scratch(new " << scratchName << "());" << std::endl;
+            for (size_t part = 0; part < parts.size(); ++part) {
+                kernel << "    scratch->part" << part << "(" << kernelArguments() << ");" << std::endl;
+            }
+        } else {
+            kernel << getConstantsDeclaration();
+            kernel << getTemporariesDeclaration() << std::endl;
+            kernel << finalAssignments();
+        }
+
+        kernel << "}" << std::endl;
+        kernel << "}" << std::endl << std::endl;
+
+        return kernel.str();
+    }
+
+    /**
+     * @brief Sources of the parts of the typed kernel, when its code is larger than levi::kernelPartMaximumSize().
+     *
+     * Each part computes a contiguous range of temporaries, stored in a scratch structure, and the last one assigns the outputs.
+     * Each part is meant to be built in its own translation unit, so that they are compiled in parallel.
+     * The vector is empty if the kernel is not split.
+     */
+    std::vector<std::string> getTypedKernelParts(const std::string& kernelName) const {
+        std::vector<std::pair<size_t, size_t>> parts = kernelPartition();
+        std::vector<std::string> sources;
+
+        if (parts.size() <= 1) {
+            return sources;
+        }
+
+        std::string scratchDefinitionCode = scratchDefinition(kernelName, parts.size());
+
+        for (size_t part = 0; part < parts.size(); ++part) {
+            std::ostringstream source;
+            source << "//This file has been autogenerated" << std::endl;
+            source << "#include \"source.h\"" << std::endl << std::endl;
+            source << scratchDefinitionCode;
+            source << "void " << kernelName << "Scratch::part" << part << "(" << kernelParameters() << ") {" << std::endl;
+
+            for (size_t t = parts[part].first; t < parts[part].second; ++t) {
+                const TemporaryDeclaration& temporary = m_temporaries[t];
+                //A temporary never appears in its own expression
+                source << "    " << temporary.name << (temporary.isScalar ? " = " : ".noalias() = ") << temporary.expression << ";" << std::endl;
+            }
+
+            if (part + 1 == parts.size()) {
+                source << std::endl << finalAssignments();
+            }
+
+            source << "}" << std::endl;
+            sources.push_back(source.str());
+        }
+
+        return sources;
+    }
+
+    /**
+     * @brief Call of the typed kernel, mapping the type-erased generics and outputs on their typed counterparts.
+     * @param outputs The names of the output matrices, one for each expression.
+     */
+    std::string getTypedKernelCall(const std::string& kernelName, const std::vector<std::string>& outputs) const {
+        assert(outputs.size() == m_finalExpressionIndices.size());
+
+        std::ostringstream call;
+        call << "    " << kernelName << "(";
+
+        std::string separator = "";
+        for (size_t generic = 0; generic < m_generics.size(); ++generic) {
+            const levi::TreeComponent<EvaluableT>& component = m_expandedExpression[m_generics[generic]];
+            std::string name = m_genericsName + "[" + std::to_string(generic) + "]";
+            call << separator << mapType(component.rows(), component.cols(), true) << "(" << name << ".data(), "
+                 << component.rows() << ", " << component.cols() << ", Eigen::OuterStride<>(" << name << ".outerStride()))";
+            separator = ",\n        ";
+        }
+
+        for (size_t output = 0; output < outputs.size(); ++output) {
+            const levi::TreeComponent<EvaluableT>& component = m_expandedExpression[m_finalExpressionIndices[output]];
+            call << separator << mapType(component.rows(), component.cols(), false) << "(" << outputs[output] << ".data(), "
+                 << component.rows() << ", " << component.cols() << ", Eigen::OuterStride<>(" << outputs[output] << ".outerStride()))";
+            separator = ",\n        ";
+        }
+
+        call << ");" << std::endl;
+
+        return call.str();
+    }
+
+    /**
+     * @brief The generics, in the order in which they are stacked in each input sample of a batch.
+     */
+    std::vector<BatchInput> batchInputs() const {
+        std::vector<BatchInput> inputs;
+        Eigen::Index offset = 0;
+        for (size_t generic = 0; generic < m_generics.size(); ++generic) {
+            const levi::TreeComponent<EvaluableT>& component = m_expandedExpression[m_generics[generic]];
+            inputs.push_back({component.partialExpression.name(), component.rows(), component.cols(), offset});
+            offset += component.rows() * component.cols();
+        }
+        return inputs;
+    }
+
+    /**
+     * @brief Loop executing body on each sample of a batch, with the parameters of CompiledEvaluable::evaluateBatch.
+     *
+     * In body, the generics and the outputs are accessed as in the evaluation of a single sample, through views on the current sample.
+     * @param outputs The names of the output matrices, one for each expression. They are stacked in each output sample.
+     */
+    std::string getBatchLoop(const std::string& body, const std::vector<std::string>& outputs) const {
+        assert(outputs.size() == m_finalExpressionIndices.size());
+
+        std::ostringstream scalarTypeStream;
+        scalarTypeStream << type_name<typename EvaluableT::value_type>();
+        std::string scalarType = scalarTypeStream.str();
+        std::vector<BatchInput> inputs = batchInputs();
+
+        std::ostringstream loop;
+        loop << "    for (size_t sample = 0; sample < n; ++sample) {" << std::endl;
+        loop << "    const " << scalarType << "* inputSample = inputs + sample * inputStride;" << std::endl;
+        loop << "    " << scalarType << "* outputSample = outputs + sample * outputStride;" << std::endl;
+
+        if (inputs.size()) {
+            loop << "    const levi::BatchView<const " << scalarType << "> " << m_genericsName << "[" << inputs.size() << "] = {";
+            std::string separator = "";
+            for (const BatchInput& input : inputs) {
+                loop << separator << "{inputSample + " << input.offset << ", " << input.rows << "}";
+                separator = ", ";
+            }
+            loop << "};" << std::endl;
+        }
+
+        Eigen::Index offset = 0;
+        for (size_t output = 0; output < outputs.size(); ++output) {
+            const levi::TreeComponent<EvaluableT>& component = m_expandedExpression[m_finalExpressionIndices[output]];
+            loop << "    levi::BatchView<" << scalarType << "> " << outputs[output] << " = {outputSample + " << offset << ", " << component.rows() << "};" << std::endl;
+            offset += component.rows() * component.cols();
+        }
+
+        loop << body;
+        loop << "    }" << std::endl;
+
+        return loop.str();
+    }
+
+    /**
+     * @brief Whether all the components of the expressions have at most maximumSize elements, so that the code can be scalarized.
+     */
+    bool isScalarizable(Eigen::Index maximumSize) const {
+        if (maximumSize <= 0) {
+            return false;
+        }
+
+        for (const levi::TreeComponent<EvaluableT>& component : m_expandedExpression) {
+            if (component.rows() * component.cols() > maximumSize) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Straight-line code computing each element of the expressions in a local scalar variable.
+     *
+     * Generics are read through the pointer to their data, and outputs are written in the same way.
+     * Accessors and concatenations do not generate any code, since they only select the variables of their arguments.
+     * The elements of Null, Identity and constants are literals, folded in the operations using them.
+     * @param outputs The names of the output matrices, one for each expression.
+     */
+    std::string getScalarizedCode(const std::vector<std::string>& outputs) const {
+        assert(outputs.size() == m_finalExpressionIndices.size());
+
+        std::ostringstream code;
+        std::vector<std::vector<std::string>> elements;
+        scalarizedValues(code, elements, nullptr);
+
+        for (size_t output = 0; output < outputs.size(); ++output) {
+            writeScalarizedOutput(code, "out" + std::to_string(output) + "_", outputs[output], elements[m_finalExpressionIndices[output]],
+                                  m_expandedExpression[m_finalExpressionIndices[output]].rows(), m_expandedExpression[m_finalExpressionIndices[output]].cols());
+        }
+
+        return code.str();
+    }
+
+    /**
+     * @brief Whether the gradient of the expression with respect to variable can be computed by getScalarizedGradientCode.
+     *
+     * The expression has to be a scalar, and all its components have to be scalarizable with at most maximumSize elements.
+     * The variable can appear only as a generic on its own, since the other generics are seen as constants.
+     */
+    bool isReverseModeAvailable(std::shared_ptr<levi::VariableBase> variable, Eigen::Index maximumSize) const {
+        if ((m_finalExpressionIndices.size() != 1) || !isScalarizable(maximumSize)) {
+            return false;
+        }
+
+        const levi::TreeComponent<EvaluableT>& output = m_expandedExpression[m_finalExpressionIndices.front()];
+        if ((output.rows() != 1) || (output.cols() != 1)) {
+            return false;
+        }
+
+        for (size_t generic : m_generics) {
+            const levi::TreeComponent<EvaluableT>& component = m_expandedExpression[generic];
+            if (!isVariable(component, variable) && component.partialExpression.isDependentFrom(variable)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Straight-line code computing the gradient of the scalar expression with the reverse mode.
+     *
+     * The forward sweep is the one of getScalarizedCode, where each intermediate value is kept in a local variable.
+     * Then, the reverse sweep accumulates the adjoint of each value, i.e. the derivative of the expression with respect to it,
+     * from the output back to the elements of the variable. Only the values depending on the variable are considered.
+     * The cost is a small multiple of the one of the expression, independently from the dimension of the variable.
+     * @param output The name of the output matrix, a row vector with the size of the variable (as getColumnDerivative).
+     */
+    std::string getScalarizedGradientCode(std::shared_ptr<levi::VariableBase> variable, const std::string& output) const {
+        assert(isReverseModeAvailable(variable, std::numeric_limits<Eigen::Index>::max()) && "The reverse mode is not available for this expression.");
+
+        std::ostringstream scalarType;
+        scalarType << type_name<typename EvaluableT::value_type>();
+
+        std::ostringstream code;
+        std::vector<std::vector<std::string>> elements;
+        std::vector<ScalarOperation> operations;
+        scalarizedValues(code, elements, &operations);
+
+        std::vector<std::string> variableElements;
+        for (size_t generic : m_generics) {
+            if (isVariable(m_expandedExpression[generic], variable)) {
+                variableElements = elements[generic];
+            }
+        }
+
+        //Forward activity: the values depending on the variable
+        std::unordered_set<std::string> active(variableElements.begin(), variableElements.end());
+        for (const ScalarOperation& operation : operations) {
+            for (const std::string& operand : operation.operands) {
+                if (active.count(operand)) {
+                    active.insert(operation.result);
+                    break;
+                }
+            }
+        }
+
+        std::unordered_set<std::string> adjoints;
+        const std::string one = scalarLiteral(1);
+
+        //The first contribution declares the adjoint. The others are accumulated.
+        auto accumulate = [&](const std::string& value, const std::string& contribution, bool negative) {
+            if (!active.count(value)) {
+                return;
+            }
+            if (adjoints.insert(value).second) {
+                code << "    " << scalarType.str() << " d" << value << " = " << (negative ? "-(" + contribution + ")" : contribution) << ";" << std::endl;
+            } else {
+                code << "    d" << value << (negative ? " -= " : " += ") << contribution << ";" << std::endl;
+            }
+        };
+
+        const std::string& result = elements[m_finalExpressionIndices.front()].front();
+        accumulate(result, one, false);
+
+        for (auto operation = operations.rbegin(); operation != operations.rend(); ++operation) {
+            if (!adjoints.count(operation->result)) {
+                continue;
+            }
+
+            const std::string adjoint = "d" + operation->result;
+            const std::vector<std::string>& operands = operation->operands;
+
+            if (operation->type == Type::Sum) {
+                accumulate(operands[0], adjoint, false);
+                accumulate(operands[1], adjoint, false);
+            } else if (operation->type == Type::Subtraction) {
+                accumulate(operands[0], adjoint, false);
+                accumulate(operands[1], adjoint, true);
+            } else if (operation->type == Type::InvertedSign) {
+                accumulate(operands[0], adjoint, true);
+            } else if (operation->type == Type::Product) { //The operands are the pairs of factors
+                for (size_t factor = 0; factor + 1 < operands.size(); factor += 2) {
+                    const std::string &a = operands[factor], &b = operands[factor + 1];
+                    accumulate(a, (b == one) ? adjoint : adjoint + " * " + b, false);
+                    accumulate(b, (a == one) ? adjoint : adjoint + " * " + a, false);
+                }
+            } else if (operation->type == Type::Division) {
+                accumulate(operands[0], adjoint + " / " + operands[1], false);
+                accumulate(operands[1], adjoint + " * " + operation->result + " / " + operands[1], true);
+            } else if (operation->type == Type::Pow) {
+                accumulate(operands[0], adjoint + " * " + scalarLiteral(operation->exponent) + " * (" +
+                           powerCode(operands[0], operation->exponent - 1) + ")", false);
+            }
+        }
+
+        std::vector<std::string> gradient;
+        for (const std::string& value : variableElements) {
+            gradient.push_back(adjoints.count(value) ? "d" + value : scalarLiteral(0));
+        }
+
+        writeScalarizedOutput(code, "out0_", output, gradient, 1, static_cast<Eigen::Index>(gradient.size()));
+
+        return code.str();
+    }
+
+private:
+
+    //An operation of the scalarized code, used to generate the reverse sweep
+    struct ScalarOperation {
+        Type type;
+        std::string result;
+        std::vector<std::string> operands; //For products, the pairs of factors
+        typename EvaluableT::value_type exponent;
+    };
+
+    //Whether the generic is the variable itself. Variables are identified by name and dimension, as in isDependentFrom.
+    static bool isVariable(const levi::TreeComponent<EvaluableT>& generic, std::shared_ptr<levi::VariableBase> variable) {
+        return (generic.partialExpression.name() == variable->variableName()) && (generic.rows() == variable->dimension()) &&
+                (generic.cols() == 1);
+    }
+
+    //Writes the elements, column-major, in the matrix with the given name, accessed through its data pointer.
+    void writeScalarizedOutput(std::ostringstream& code, const std::string& pointer, const std::string& output,
+                               const std::vector<std::string>& values, Eigen::Index rows, Eigen::Index cols) const {
+        code << "    " << type_name<typename EvaluableT::value_type>() << "* " << pointer << " = " << output << ".data();" << std::endl;
+        code << "    const Eigen::Index " << pointer << "stride = " << output << ".outerStride();" << std::endl;
+
+        for (Eigen::Index col = 0; col < cols; ++col) {
+            for (Eigen::Index row = 0; row < rows; ++row) {
+                code << "    " << pointer << "[" << row;
+                if (col > 0) {
+                    code << " + " << col << " * " << pointer << "stride";
+                }
+                code << "] = " << values[static_cast<size_t>(row + col * rows)] << ";" << std::endl;
+            }
+        }
+    }
+
+    //The forward sweep of the scalarized code. Each element of each component is named in elements.
+    //If operations is not null, it is filled with the operations defining the local variables, in order.
+    void scalarizedValues(std::ostringstream& code, std::vector<std::vector<std::string>>& elements, std::vector<ScalarOperation>* operations) const {
+        std::ostringstream scalarType;
+        scalarType << type_name<typename EvaluableT::value_type>();
+
+        elements.assign(m_expandedExpression.size(), std::vector<std::string>());
+
+        auto element = [this, &elements](size_t component, Eigen::Index row, Eigen::Index col) -> const std::string& {
+            return elements[component][static_cast<size_t>(row + col * m_expandedExpression[component].rows())];
+        };
+
+        for (size_t generic = 0; generic < m_generics.size(); ++generic) {
+            const levi::TreeComponent<EvaluableT>& component = m_expandedExpression[m_generics[generic]];
+            std::string pointer = "in" + std::to_string(generic) + "_";
+
+            code << "    const " << scalarType.str() << "* " << pointer << " = " << m_genericsName << "[" << generic << "].data();" << std::endl;
+            code << "    const Eigen::Index " << pointer << "stride = " << m_genericsName << "[" << generic << "].outerStride();" << std::endl;
+
+            for (Eigen::Index col = 0; col < component.cols(); ++col) {
+                for (Eigen::Index row = 0; row < component.rows(); ++row) {
+                    std::string name = pointer + std::to_string(row + col * component.rows());
+                    code << "    const " << scalarType.str() << " " << name << " = " << pointer << "[" << row;
+                    if (col > 0) {
+                        code << " + " << col << " * " << pointer << "stride";
+                    }
+                    code << "];" << std::endl;
+                    elements[m_generics[generic]].push_back(name);
+                }
+            }
+        }
+
+        const std::string zero = scalarLiteral(0), one = scalarLiteral(1);
+
+        for (size_t i = 0; i < m_expandedExpression.size(); ++i) {
+            const levi::TreeComponent<EvaluableT>& component = m_expandedExpression[i];
+            Type type = component.type;
+
+            if (type == Type::Generic) {
+                continue;
+            }
+
+            size_t lhs = component.lhsIndex, rhs = component.rhsIndex;
+            const levi::TreeComponent<EvaluableT>& lhsComponent = m_expandedExpression[lhs];
+            const levi::TreeComponent<EvaluableT>& rhsComponent = m_expandedExpression[rhs];
+
+            for (Eigen::Index col = 0; col < component.cols(); ++col) {
+                for (Eigen::Index row = 0; row < component.rows(); ++row) {
+
+                    if (type == Type::Null) {
+                        elements[i].push_back(zero);
+                        continue;
+                    } else if (type == Type::Identity) {
+                        elements[i].push_back((row == col) ? one : zero);
+                        continue;
+                    } else if (type == Type::Constant) {
+                        elements[i].push_back(scalarLiteral(component.buffer(row, col)));
+                        continue;
+                    } else if (type == Type::Horzcat) {
+                        elements[i].push_back((col < lhsComponent.cols()) ? element(lhs, row, col) : element(rhs, row, col - lhsComponent.cols()));
+                        continue;
+                    } else if (type == Type::Vertcat) {
+                        elements[i].push_back((row < lhsComponent.rows()) ? element(lhs, row, col) : element(rhs, row - lhsComponent.rows(), col));
+                        continue;
+                    } else if (type == Type::Transpose) {
+                        elements[i].push_back(element(lhs, col, row));
+                        continue;
+                    } else if (type == Type::Row) {
+                        elements[i].push_back(element(lhs, component.block.startRow, col));
+                        continue;
+                    } else if (type == Type::Column) {
+                        elements[i].push_back(element(lhs, row, component.block.startCol));
+                        continue;
+                    } else if (type == Type::Element) {
+                        elements[i].push_back(element(lhs, component.block.startRow, component.block.startCol));
+                        continue;
+                    } else if (type == Type::Block) {
+                        elements[i].push_back(element(lhs, component.block.startRow + row, component.block.startCol + col));
+                        continue;
+                    }
+
+                    //Zeros and ones coming from Null, Identity and constants are folded. When the result is one of the operands, no code is generated.
+                    std::ostringstream value;
+                    value << std::setprecision(std::numeric_limits<typename EvaluableT::value_type>::max_digits10);
+                    const std::string* alias = nullptr;
+                    std::vector<std::string> operands;
+
+                    if (type == Type::Sum) {
+                        const std::string &a = element(lhs, row, col), &b = element(rhs, row, col);
+                        if (a == zero) {
+                            alias = &b;
+                        } else if (b == zero) {
+                            alias = &a;
+                        } else {
+                            value << a << " + " << b;
+                            operands = {a, b};
+                        }
+                    } else if (type == Type::Subtraction) {
+                        const std::string &a = element(lhs, row, col), &b = element(rhs, row, col);
+                        if (b == zero) {
+                            alias = &a;
+                        } else if (a == zero) {
+                            value << "-" << b;
+                        } else {
+                            value << a << " - " << b;
+                        }
+                        operands = {a, b};
+                    } else if (type == Type::InvertedSign) {
+                        const std::string& a = element(lhs, row, col);
+                        if (a == zero) {
+                            alias = &zero;
+                        } else {
+                            value << "-" << a;
+                            operands = {a};
+                        }
+                    } else if (type == Type::Product) {
+                        std::vector<std::pair<const std::string*, const std::string*>> factors;
+                        if (lhsComponent.cols() == rhsComponent.rows()) {
+                            for (Eigen::Index k = 0; k < lhsComponent.cols(); ++k) {
+                                factors.emplace_back(&element(lhs, row, k), &element(rhs, k, col));
+                            }
+                        } else if (lhsComponent.rows() == 1 && lhsComponent.cols() == 1) {
+                            factors.emplace_back(&element(lhs, 0, 0), &element(rhs, row, col));
+                        } else {
+                            factors.emplace_back(&element(lhs, row, col), &element(rhs, 0, 0));
+                        }
+
+                        std::vector<const std::string*> products;
+                        std::string separator = "";
+                        for (auto& factor : factors) {
+                            if ((*factor.first == zero) || (*factor.second == zero)) {
+                                continue;
+                            }
+                            value << separator;
+                            if (*factor.first == one) {
+                                value << *factor.second;
+                                products.push_back(factor.second);
+                            } else if (*factor.second == one) {
+                                value << *factor.first;
+                                products.push_back(factor.first);
+                            } else {
+                                value << *factor.first << " * " << *factor.second;
+                                products.push_back(nullptr);
+                            }
+                            separator = " + ";
+                            operands.push_back(*factor.first);
+                            operands.push_back(*factor.second);
+                        }
+
+                        if (products.empty()) {
+                            alias = &zero;
+                        } else if (products.size() == 1 && products.front()) {
+                            alias = products.front();
+                        }
+                    } else if (type == Type::Division) {
+                        const std::string &a = element(lhs, row, col), &b = element(rhs, 0, 0);
+                        if (b == one) {
+                            alias = &a;
+                        } else {
+                            value << a << " / " << b;
+                            operands = {a, b};
+                        }
+                    } else if (type == Type::Pow) {
+                        const std::string &a = element(lhs, 0, 0);
+                        if (component.exponent == 1) {
+                            alias = &a;
+                        } else if (component.exponent == 0) {
+                            alias = &one;
+                        } else {
+                            value << powerCode(a, component.exponent);
+                            operands = {a};
+                        }
+                    } else {
+                        assert(false && "Unsupported type in scalarized code.");
+                    }
+
+                    if (alias) {
+                        elements[i].push_back(*alias);
+                        continue;
+                    }
+
+                    std::string name = "v" + std::to_string(i) + "_" + std::to_string(row + col * component.rows());
+                    code << "    const " << scalarType.str() << " " << name << " = " << value.str() << ";" << std::endl;
+                    elements[i].push_back(name);
+
+                    if (operations) {
+                        operations->push_back({type, name, operands, component.exponent});
+                    }
+                }
+            }
+        }
+    }
+
 
 
 };
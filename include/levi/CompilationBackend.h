@@ -0,0 +1,129 @@
+/*
+* Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+* Authors: Stefano Dafarra
+* CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+*
+*/
+#ifndef LEVI_COMPILATIONBACKEND_H
+#define LEVI_COMPILATIONBACKEND_H
+
+#include <levi/HelpersForwardDeclarations.h>
+#include <levi/autogenerated/Path.h>
+#include <cstdlib>
+#include <iostream>
+
+namespace levi {
+
+    /**
+     * @brief The tool used to build the autogenerated libraries.
+     */
+    enum class CompilationBackend {
+        CMake, //Configure and build a CMake project for each library
+        Compiler, //Invoke directly the compiler used to build levi, with a precompiled header. If it fails, CMake is used instead.
+        SourcesOnly //Only write the sources in generatedSourcesDirectory(), to be built ahead of time (see levi_add_generated_expressions)
+    };
+
+    /**
+     * @brief Whether the compiler used to build levi can be invoked directly with gcc-like options.
+     */
+    inline bool isCompilerBackendAvailable() {
+        std::string compilerId = LEVI_CXX_COMPILER_ID;
+        return std::string(LEVI_CXX_COMPILER).size() && (compilerId == "GNU" || compilerId == "Clang" || compilerId == "AppleClang");
+    }
+
+    /**
+     * @brief The backend used to build the autogenerated libraries.
+     *
+     * By default, the compiler is invoked directly when possible. The environment variable LEVI_COMPILATION_BACKEND set to "cmake" selects CMake.
+     */
+    inline levi::CompilationBackend& compilationBackend() {
+        static levi::CompilationBackend backend = (isCompilerBackendAvailable() && !(std::getenv("LEVI_COMPILATION_BACKEND") &&
+                                                                                     std::string(std::getenv("LEVI_COMPILATION_BACKEND")) == "cmake")) ?
+                    levi::CompilationBackend::Compiler : levi::CompilationBackend::CMake;
+        return backend;
+    }
+
+    inline void setCompilationBackend(levi::CompilationBackend backend) {
+        assert((backend != levi::CompilationBackend::Compiler || isCompilerBackendAvailable()) && "The compiler cannot be invoked directly.");
+        compilationBackend() = backend;
+    }
+
+    /**
+     * @brief Directory where the sources are written with the SourcesOnly backend. Each library has a subfolder named after it.
+     */
+    inline std::string& generatedSourcesDirectory() {
+        static std::string directory = ".";
+        return directory;
+    }
+
+    inline void setGeneratedSourcesDirectory(const std::string& directory) {
+        generatedSourcesDirectory() = directory;
+    }
+
+    /**
+     * @brief Maximum number of elements of each component of an expression for the generated code to be scalarized.
+     *
+     * Scalarized code computes each element in a local variable, without using Eigen. Set to 0 to always generate Eigen code.
+     */
+    inline Eigen::Index& scalarizationMaximumSize() {
+        static Eigen::Index maximumSize = 16;
+        return maximumSize;
+    }
+
+    inline void setScalarizationMaximumSize(Eigen::Index maximumSize) {
+        scalarizationMaximumSize() = maximumSize;
+    }
+
+    /**
+     * @brief Maximum number of elements of each component of a scalar expression for its gradient to be generated with the reverse mode.
+     *
+     * Larger expressions are differentiated symbolically, column by column (see ExpressionComponent::compileGradient).
+     */
+    inline Eigen::Index& reverseModeMaximumSize() {
+        static Eigen::Index maximumSize = 1024;
+        return maximumSize;
+    }
+
+    inline void setReverseModeMaximumSize(Eigen::Index maximumSize) {
+        reverseModeMaximumSize() = maximumSize;
+    }
+
+    /**
+     * @brief Maximum size, in characters, of the code of each function of the generated Eigen code.
+     *
+     * Larger kernels are split in several functions, each one in its own source file, which are compiled in parallel.
+     * Set to 0 to always generate a single function.
+     */
+    inline size_t& kernelPartMaximumSize() {
+        static size_t maximumSize = 100000;
+        return maximumSize;
+    }
+
+    inline void setKernelPartMaximumSize(size_t maximumSize) {
+        kernelPartMaximumSize() = maximumSize;
+    }
+
+    /**
+     * @brief Time spent in the phases of the generation of a compiled expression, in milliseconds.
+     */
+    struct CompilationTimings {
+        double codeGeneration = 0;
+        double writingSources = 0;
+        double precompiledHeader = 0;
+        double configuration = 0;
+        double building = 0;
+        double loading = 0;
+
+        double total() const {
+            return codeGeneration + writingSources + precompiledHeader + configuration + building + loading;
+        }
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const levi::CompilationTimings& timings) {
+        return os << "code generation " << timings.codeGeneration << ", writing sources " << timings.writingSources
+                  << ", precompiled header " << timings.precompiledHeader << ", configuration " << timings.configuration
+                  << ", building " << timings.building << ", loading " << timings.loading << " (total " << timings.total() << ")";
+    }
+}
+
+#endif // LEVI_COMPILATIONBACKEND_H
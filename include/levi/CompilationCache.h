@@ -0,0 +1,79 @@
+/*
+* Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+* Authors: Stefano Dafarra
+* CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+*
+*/
+#ifndef LEVI_COMPILATIONCACHE_H
+#define LEVI_COMPILATIONCACHE_H
+
+#include <levi/HelpersForwardDeclarations.h>
+#include <cstdlib>
+#include <cstdint>
+#include <sstream>
+#include <iomanip>
+
+namespace levi {
+
+    /**
+     * @brief Directory storing the libraries compiled from expressions, so that they are reused by following runs.
+     *
+     * An empty string disables the cache. By default, it is the value of the environment variable LEVI_COMPILATION_CACHE_DIR, if defined.
+     */
+    inline std::string& compilationCacheDirectory() {
+        static std::string directory = std::getenv("LEVI_COMPILATION_CACHE_DIR") ? std::getenv("LEVI_COMPILATION_CACHE_DIR") : "";
+        return directory;
+    }
+
+    /**
+     * @brief Set the directory of the compilation cache. Use an empty string to disable it.
+     */
+    inline void setCompilationCacheDirectory(const std::string& directory) {
+        compilationCacheDirectory() = directory;
+    }
+
+    /**
+     * @brief Incremental 64-bit FNV-1a hash. It does not depend on the standard library implementation, hence it can be stored.
+     */
+    class ContentHash {
+        uint64_t m_hash = 14695981039346656037ULL;
+
+    public:
+
+        ContentHash& add(const std::string& content) {
+            for (unsigned char c : content) {
+                m_hash ^= c;
+                m_hash *= 1099511628211ULL;
+            }
+            m_hash ^= 0xff; //separator, so that the split among the added strings matters
+            m_hash *= 1099511628211ULL;
+            return *this;
+        }
+
+        std::string hex() const {
+            std::ostringstream output;
+            output << std::hex << std::setw(16) << std::setfill('0') << m_hash;
+            return output.str();
+        }
+    };
+
+    /**
+     * @brief Description of the compiler and of the flags used to build the autogenerated libraries.
+     */
+    inline std::string compilerSignature() {
+        std::string signature;
+#ifdef __VERSION__
+        signature += __VERSION__;
+#endif
+#ifdef _MSC_FULL_VER
+        signature += "msvc" + std::to_string(_MSC_FULL_VER);
+#endif
+        for (const char* variable : {"CXX", "CXXFLAGS", "CMAKE_GENERATOR", "CMAKE_PREFIX_PATH"}) {
+            const char* value = std::getenv(variable);
+            signature += std::string(";") + variable + "=" + (value ? value : "");
+        }
+        return signature;
+    }
+}
+
+#endif // LEVI_COMPILATIONCACHE_H
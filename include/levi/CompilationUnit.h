@@ -0,0 +1,151 @@
+/*
+* Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+* Authors: Stefano Dafarra
+* CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+*
+*/
+#ifndef LEVI_COMPILATIONUNIT_H
+#define LEVI_COMPILATIONUNIT_H
+
+#include <levi/ForwardDeclarations.h>
+#include <levi/HelpersForwardDeclarations.h>
+#include <levi/AutogeneratedHelper.h>
+#include <levi/AutogeneratedEvaluable.h>
+#include <levi/CompiledEvaluable.h>
+
+/**
+ * @brief Collects many expressions and compiles them in a single library, which is built and loaded once.
+ *
+ * Each expression added to the unit has its own evaluable, which is evaluated by squeezing it until compile() is called.
+ * Then, all the evaluables use the instances created by the shared library.
+ */
+template <typename EvaluableT>
+class levi::CompilationUnit {
+public:
+
+    using Matrix = Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic>;
+
+private:
+
+    using evaluable_type = levi::AutogeneratedEvaluable<EvaluableT>;
+    using base_type = typename evaluable_type::base_type;
+    using collection_type = levi::CompiledCollection<base_type>;
+
+    struct Entry {
+        std::weak_ptr<evaluable_type> evaluable;
+        levi::GeneratedSources sources;
+    };
+
+    //Keeps the library loaded as long as one of its instances is used
+    struct Library {
+        levi::CompiledEvaluableFactory<collection_type> collection;
+    };
+
+    std::string m_name;
+    levi::CompileOptions m_options;
+    std::vector<Entry> m_entries;
+    levi::AutogeneratedHelper<EvaluableT> m_helper;
+    std::shared_ptr<Library> m_library;
+
+public:
+
+    /**
+     * @brief Constructor
+     * @param name The name of the library.
+     * @param options The profile used to build the library.
+     */
+    CompilationUnit(const std::string& name, const levi::CompileOptions& options = levi::CompileOptions())
+        : m_name(name)
+        , m_options(options)
+    { }
+
+    /**
+     * @brief Adds an expression to the unit.
+     * @param expression The expression to be compiled.
+     * @param name The name of the expression. It has to be unique in the unit.
+     * @return The compiled expression. It is evaluated by squeezing it until compile() is called.
+     */
+    levi::ExpressionComponent<levi::Evaluable<Matrix>> add(const levi::ExpressionComponent<EvaluableT>& expression, const std::string& name) {
+        assert(!m_library && "The unit has already been compiled.");
+
+        Entry newEntry;
+        levi::ExpressionComponent<evaluable_type> compiled(expression, name, m_options, newEntry.sources);
+
+        for (const Entry& entry : m_entries) {
+            assert(entry.sources.className != newEntry.sources.className && "Two expressions of the unit have the same name.");
+            levi::unused(entry);
+        }
+
+        newEntry.evaluable = compiled.evaluable();
+        m_entries.push_back(std::move(newEntry));
+
+        return compiled;
+    }
+
+    size_t size() const {
+        return m_entries.size();
+    }
+
+    /**
+     * @brief Builds and loads the library with all the expressions added so far.
+     * @return False if the library has not been loaded, since the SourcesOnly backend is in use.
+     */
+    bool compile() {
+        assert(!m_library && "The unit has already been compiled.");
+        assert(m_entries.size() && "The unit is empty.");
+
+        m_helper.setExpressions({}, m_name, m_options);
+        std::string collectionName = m_helper.name() + "Collection";
+
+        std::ostringstream header;
+        header << "//This file has been autogenerated" << std::endl;
+        header << "#ifndef LEVI_UNIT" << m_helper.name() << "_H" << std::endl;
+        header << "#define LEVI_UNIT" << m_helper.name() << "_H" << std::endl;
+        for (const Entry& entry : m_entries) {
+            header << entry.sources.header;
+        }
+        header << "class " << collectionName << ": public " << type_name<collection_type>() << " {" << std::endl;
+        header << "public:" << std::endl;
+        header << "    virtual " << type_name<base_type>() << "* create(size_t index) final;" << std::endl;
+        header << "};" << std::endl;
+        header << "#endif //LEVI_UNIT" << m_helper.name() << "_H" << std::endl;
+
+        std::ostringstream cpp;
+        std::vector<std::string> kernelParts;
+        for (const Entry& entry : m_entries) {
+            cpp << entry.sources.cpp;
+            kernelParts.insert(kernelParts.end(), entry.sources.kernelParts.begin(), entry.sources.kernelParts.end());
+        }
+        cpp << type_name<base_type>() << "* " << collectionName << "::create(size_t index) {" << std::endl;
+        cpp << "    switch (index) {" << std::endl;
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            cpp << "    case " << i << ": return new " << m_entries[i].sources.className << "();" << std::endl;
+        }
+        cpp << "    default: return nullptr;" << std::endl;
+        cpp << "    }" << std::endl;
+        cpp << "}" << std::endl;
+
+        std::shared_ptr<Library> library = std::make_shared<Library>();
+
+        if (!m_helper.compile(header.str(), cpp.str(), library->collection, collectionName, kernelParts)) {
+            return false;
+        }
+
+        m_library = library;
+
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            std::shared_ptr<evaluable_type> evaluable = m_entries[i].evaluable.lock();
+            if (evaluable) {
+                evaluable->setCompiledInstance(library->collection->create(i), library);
+            }
+        }
+
+        return true;
+    }
+
+    const levi::CompilationTimings& compilationTimings() const {
+        return m_helper.compilationTimings();
+    }
+};
+
+#endif // LEVI_COMPILATIONUNIT_H
@@ -0,0 +1,109 @@
+/*
+* Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+* Authors: Stefano Dafarra
+* CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+*
+*/
+#ifndef LEVI_COMPILEOPTIONS_H
+#define LEVI_COMPILEOPTIONS_H
+
+#include <string>
+
+namespace levi {
+
+    /**
+     * @brief Profile used to build a compiled expression.
+     *
+     * The default profile corresponds to a generic Release build. A different profile is encoded in the name of the library,
+     * so that libraries of the same expression built with different profiles can coexist.
+     */
+    struct CompileOptions {
+        int optimizationLevel = 3;
+        std::string architecture; //Target instruction set, e.g. "native", "haswell" or "skylake-avx512". Empty to use the compiler default.
+        bool fusedMultiplyAdd = false; //Allow contracting multiplications and additions in fused operations
+        bool fastMath = false; //Allow relaxations of the IEEE floating point rules
+        bool linkTimeOptimization = false;
+        std::string additionalFlags;
+
+        /**
+         * @brief The compiler flags corresponding to the profile.
+         */
+        std::string flags() const {
+            std::string flags;
+#ifdef _MSC_VER
+            flags = (optimizationLevel > 0) ? "/O2 /DNDEBUG" : "/Od /DNDEBUG";
+            if (architecture.size()) {
+                flags += " /arch:" + architecture;
+            }
+            if (fusedMultiplyAdd) {
+                flags += " /fp:contract";
+            }
+            if (fastMath) {
+                flags += " /fp:fast";
+            }
+            if (linkTimeOptimization) {
+                flags += " /GL";
+            }
+#else
+            flags = "-O" + std::to_string(optimizationLevel) + " -DNDEBUG";
+            if (architecture.size()) {
+                flags += " -march=" + architecture;
+            }
+            flags += fusedMultiplyAdd ? " -ffp-contract=fast" : " -ffp-contract=off";
+            if (fastMath) {
+                flags += " -ffast-math";
+            }
+            if (linkTimeOptimization) {
+                flags += " -flto";
+            }
+#endif
+            if (additionalFlags.size()) {
+                flags += " " + additionalFlags;
+            }
+            return flags;
+        }
+
+        bool isDefault() const {
+            return flags() == CompileOptions().flags();
+        }
+
+        /**
+         * @brief A short tag describing the profile, which can be used in identifiers. It is empty for the default profile.
+         */
+        std::string profileName() const {
+            if (isDefault()) {
+                return "";
+            }
+
+            std::string name = "O" + std::to_string(optimizationLevel);
+            if (architecture.size()) {
+                name += "_" + architecture;
+            }
+            if (fusedMultiplyAdd) {
+                name += "_fma";
+            }
+            if (fastMath) {
+                name += "_fastmath";
+            }
+            if (linkTimeOptimization) {
+                name += "_lto";
+            }
+            if (additionalFlags.size()) {
+                size_t hash = 5381; //djb2, stable across runs
+                for (unsigned char c : additionalFlags) {
+                    hash = hash * 33 + c;
+                }
+                name += "_x" + std::to_string(hash % 1000000);
+            }
+
+            for (char& letter : name) {
+                if (!(((letter >= 'a') && (letter <= 'z')) || ((letter >= 'A') && (letter <= 'Z')) || ((letter >= '0') && (letter <= '9')))) {
+                    letter = '_';
+                }
+            }
+            return name;
+        }
+    };
+}
+
+#endif // LEVI_COMPILEOPTIONS_H
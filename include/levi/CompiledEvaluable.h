@@ -19,6 +19,48 @@ public:
     virtual ~CompiledEvaluable() { }
 
     virtual void evaluate(const std::vector<GenericsMatrix>& generics, OutputMatrix output) = 0;
+
+    /**
+     * @brief Evaluates n samples. Each sample of inputs contains the generics stacked column-major, each sample of outputs the output matrix.
+     * @param inputStride Distance between two consecutive input samples.
+     * @param outputStride Distance between two consecutive output samples.
+     */
+    virtual void evaluateBatch(const typename GenericsMatrix::Scalar* inputs, size_t inputStride,
+                               typename GenericsMatrix::Scalar* outputs, size_t outputStride, size_t n) {
+        levi::unused(inputs, inputStride, outputs, outputStride, n);
+        assert(false && "The batched evaluation is not available for this compiled evaluable.");
+    }
+};
+
+/**
+ * @brief Entry point of a library built by a CompilationUnit. It creates the compiled evaluables of the unit, given their index.
+ */
+template<typename BaseType>
+class levi::CompiledCollection {
+public:
+
+    CompiledCollection() {}
+
+    virtual ~CompiledCollection() { }
+
+    virtual BaseType* create(size_t index) = 0;
+};
+
+/**
+ * @brief Column-major view on a matrix of a sample in a batch. It exposes the accessors used by the generated code on the generics and on the outputs.
+ */
+template<typename Scalar>
+struct levi::BatchView {
+    Scalar* pointer;
+    Eigen::Index stride;
+
+    Scalar* data() const {
+        return pointer;
+    }
+
+    Eigen::Index outerStride() const {
+        return stride;
+    }
 };
 
 #endif // LEVI_COMPILEDEVALUABLE_H
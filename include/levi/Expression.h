@@ -9,6 +9,7 @@
 
 #include <levi/HelpersForwardDeclarations.h>
 #include <levi/ForwardDeclarations.h>
+#include <levi/CompileOptions.h>
 
 namespace levi {
 
@@ -76,6 +77,8 @@ namespace levi {
 
     typedef MultipleCompiledOutputPointer<LEVI_DEFAULT_MATRIX_TYPE> DefaultMultipleCompiledOutputPointer;
 
+    typedef CompilationUnit<levi::Evaluable<LEVI_DEFAULT_MATRIX_TYPE>> DefaultCompilationUnit;
+
     template <typename Matrix>
     using MultipleSqueezedOutputPointer = std::unique_ptr<levi::MultipleSqueezedExpressions<levi::Evaluable<Matrix>>>;
 
@@ -87,10 +90,11 @@ namespace levi {
     typedef std::unordered_map<std::string, LEVI_DEFAULT_MATRIX_TYPE> DefaultMultipleExpressionsOutputMap;
 
     template <typename Matrix>
-    MultipleCompiledOutputPointer<Matrix> CompileMultipleExpressions(const MultipleExpressionsMap<Matrix>& elements, const std::string& name);
+    MultipleCompiledOutputPointer<Matrix> CompileMultipleExpressions(const MultipleExpressionsMap<Matrix>& elements, const std::string& name,
+                                                                     const levi::CompileOptions& options = levi::CompileOptions());
 
     template <typename Matrix>
-    MultipleSqueezedOutputPointer<Matrix> SqueezeMultipleExpressions(const MultipleExpressionsMap<Matrix>& elements);
+    MultipleSqueezedOutputPointer<Matrix> SqueezeMultipleExpressions(const MultipleExpressionsMap<Matrix>& elements, size_t numberOfThreads = 1);
 
     template<typename LeftEvaluable, typename RightEvaluable>
     ExpressionComponent<Evaluable<Eigen::Matrix<typename levi::scalar_product_return<typename LeftEvaluable::value_type,
@@ -543,15 +547,56 @@ public:
 
     /**
      * @brief Generates a new expression condensing all the nodes in one. This expression canno be derived.
+     * @param name The name of the new expression
+     * @param numberOfThreads If greater than 1, independent nodes are evaluated in parallel on a pool of this many threads.
+     * Only the levels of the tree with enough work are split among threads.
      * @return A new expression containing the condensed version of the current expression
      */
-    ExpressionComponent<levi::Evaluable<Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic>>> squeeze(const std::string &name) const;
+    ExpressionComponent<levi::Evaluable<Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic>>> squeeze(const std::string &name, size_t numberOfThreads = 1) const;
 
     /**
      * @brief Generates a new expression condensing all the nodes in one. This expression canno be derived.
+     * @param name The name of the new expression
+     * @param options The profile used to build the compiled library
      * @return A new expression containing the condensed version of the current expression
      */
-    ExpressionComponent<levi::Evaluable<Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic>>> compile(const std::string &name) const;
+    ExpressionComponent<levi::Evaluable<Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic>>> compile(const std::string &name,
+                                                                                                                             const levi::CompileOptions& options = levi::CompileOptions()) const;
+
+    /**
+     * @brief Generates a new expression which is compiled in background. Until the compiled library is loaded, it is evaluated as a squeezed expression.
+     *
+     * Use isReady() and waitUntilReady() of the underlying evaluable to check the status of the compilation.
+     * @return A new expression containing the condensed version of the current expression
+     */
+    ExpressionComponent<levi::AutogeneratedEvaluable<EvaluableT>> compileAsync(const std::string &name, const levi::CompileOptions& options = levi::CompileOptions()) const;
+
+    /**
+     * @brief Compiles the expression together with the derivatives of its columns with respect to the specified variables.
+     *
+     * A single kernel computes all of them, hence the subexpressions shared by the value and the derivatives are computed once per evaluation.
+     * The output named "value" contains the value of the expression. The derivative of column j with respect to a variable is named
+     * as the variable if the expression has a single column, otherwise it is named "<variable name>_<j>".
+     * @param variables The variables of interest
+     * @param name The name of the compiled library
+     * @param options The profile used to build the compiled library
+     */
+    levi::MultipleCompiledOutputPointer<Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic>>
+    compileWithDerivatives(const std::vector<std::shared_ptr<levi::VariableBase>>& variables, const std::string &name,
+                           const levi::CompileOptions& options = levi::CompileOptions()) const;
+
+    /**
+     * @brief Compiles the gradient of a scalar expression with respect to the specified variable, as a row vector.
+     *
+     * The generated code uses the reverse mode, hence its cost is a small multiple of the cost of the expression,
+     * independently from the dimension of the variable. If the reverse mode is not available, e.g. because the variable
+     * appears in nodes not supported by the code generation, the column derivative is compiled instead.
+     * @param variable The variable of interest
+     * @param name The name of the compiled library
+     * @param options The profile used to build the compiled library
+     */
+    ExpressionComponent<levi::AutogeneratedGradient<EvaluableT>> compileGradient(std::shared_ptr<levi::VariableBase> variable, const std::string &name,
+                                                                                const levi::CompileOptions& options = levi::CompileOptions()) const;
 
     /**
      * @brief Retrieve the column derivative with respect to the specified variable
@@ -15,8 +15,10 @@
 #include <levi/Variable.h>
 #include <levi/AddendsExpander.h>
 #include <levi/AutogeneratedEvaluable.h>
+#include <levi/AutogeneratedGradient.h>
 #include <levi/MultipleSqueezedExpressions.h>
 #include <levi/MultipleCompiledExpressions.h>
+#include <levi/CompilationUnit.h>
 #include <levi/Assignable.h>
 
 template<bool value, typename T>
@@ -51,13 +53,14 @@ levi::ComposeByCols(const std::vector<levi::ExpressionComponent<EvaluableT>>& co
 }
 
 template <typename Matrix>
-levi::MultipleCompiledOutputPointer<Matrix> levi::CompileMultipleExpressions(const levi::MultipleExpressionsMap<Matrix> &elements, const std::string& name) {
-    return std::make_unique<levi::MultipleCompiledExpressions<levi::Evaluable<Matrix>>>(elements, name);
+levi::MultipleCompiledOutputPointer<Matrix> levi::CompileMultipleExpressions(const levi::MultipleExpressionsMap<Matrix> &elements, const std::string& name,
+                                                                             const levi::CompileOptions& options) {
+    return std::make_unique<levi::MultipleCompiledExpressions<levi::Evaluable<Matrix>>>(elements, name, options);
 }
 
 template <typename Matrix>
-levi::MultipleSqueezedOutputPointer<Matrix> levi::SqueezeMultipleExpressions(const levi::MultipleExpressionsMap<Matrix> &elements) {
-    return std::make_unique<levi::MultipleSqueezedExpressions<levi::Evaluable<Matrix>>>(elements);
+levi::MultipleSqueezedOutputPointer<Matrix> levi::SqueezeMultipleExpressions(const levi::MultipleExpressionsMap<Matrix> &elements, size_t numberOfThreads) {
+    return std::make_unique<levi::MultipleSqueezedExpressions<levi::Evaluable<Matrix>>>(elements, numberOfThreads);
 }
 
 template<typename LeftEvaluable, typename RightEvaluable>
@@ -904,18 +907,59 @@ levi::ExpressionComponent<levi::EvaluableVariable<typename EvaluableT::col_type>
 
 template<class EvaluableT>
 levi::ExpressionComponent<levi::Evaluable<Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic>>>
-levi::ExpressionComponent<EvaluableT>::squeeze(const std::string& name) const {
+levi::ExpressionComponent<EvaluableT>::squeeze(const std::string& name, size_t numberOfThreads) const {
     assert(m_evaluable && "Cannot squeeze this expression. It is empty.");
 
-    return levi::ExpressionComponent<levi::SqueezeEvaluable<EvaluableT>>(*this, name);
+    return levi::ExpressionComponent<levi::SqueezeEvaluable<EvaluableT>>(*this, name, numberOfThreads);
 }
 
 template<class EvaluableT>
 levi::ExpressionComponent<levi::Evaluable<Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic>>>
-levi::ExpressionComponent<EvaluableT>::compile(const std::string& name) const {
+levi::ExpressionComponent<EvaluableT>::compile(const std::string& name, const levi::CompileOptions& options) const {
     assert(m_evaluable && "Cannot squeeze compile expression. It is empty.");
 
-    return levi::ExpressionComponent<levi::AutogeneratedEvaluable<EvaluableT>>(*this, name);
+    return levi::ExpressionComponent<levi::AutogeneratedEvaluable<EvaluableT>>(*this, name, options);
+}
+
+template<class EvaluableT>
+levi::ExpressionComponent<levi::AutogeneratedEvaluable<EvaluableT>>
+levi::ExpressionComponent<EvaluableT>::compileAsync(const std::string& name, const levi::CompileOptions& options) const {
+    assert(m_evaluable && "Cannot compile expression. It is empty.");
+
+    return levi::ExpressionComponent<levi::AutogeneratedEvaluable<EvaluableT>>(*this, name, options, true);
+}
+
+template<class EvaluableT>
+levi::MultipleCompiledOutputPointer<Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic>>
+levi::ExpressionComponent<EvaluableT>::compileWithDerivatives(const std::vector<std::shared_ptr<levi::VariableBase>>& variables, const std::string& name,
+                                                              const levi::CompileOptions& options) const {
+    assert(m_evaluable && "Cannot compile expression. It is empty.");
+
+    using Matrix = Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic>;
+
+    levi::MultipleExpressionsMap<Matrix> elements;
+    elements["value"] = *this;
+
+    for (const std::shared_ptr<levi::VariableBase>& variable : variables) {
+        assert(variable && "Empty variable pointer.");
+        for (Eigen::Index column = 0; column < cols(); ++column) {
+            std::string derivativeName = (cols() == 1) ? variable->variableName() : variable->variableName() + "_" + std::to_string(column);
+            assert(elements.find(derivativeName) == elements.end() && "Two outputs have the same name.");
+            elements[derivativeName] = getColumnDerivative(column, variable);
+        }
+    }
+
+    return levi::CompileMultipleExpressions<Matrix>(elements, name, options);
+}
+
+template<class EvaluableT>
+levi::ExpressionComponent<levi::AutogeneratedGradient<EvaluableT>>
+levi::ExpressionComponent<EvaluableT>::compileGradient(std::shared_ptr<levi::VariableBase> variable, const std::string& name,
+                                                      const levi::CompileOptions& options) const {
+    assert(m_evaluable && "Cannot compile expression. It is empty.");
+    assert(variable && "Empty variable pointer.");
+
+    return levi::ExpressionComponent<levi::AutogeneratedGradient<EvaluableT>>(*this, variable, name, options);
 }
 
 template<typename EvaluableT>
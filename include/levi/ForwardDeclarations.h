@@ -202,15 +202,23 @@ namespace levi {
     template<typename EvaluableT>
     class AutogeneratedEvaluable;
 
+    template<typename EvaluableT>
+    class AutogeneratedGradient;
+
     template<typename EvaluableT>
     class TreeComponent;
 
     template<typename EvaluableT>
     class MultipleExpressionsEvaluator;
 
+    class ThreadPool;
+
     template<typename EvaluableT>
     class MultipleCompiledExpressions;
 
+    template<typename EvaluableT>
+    class CompilationUnit;
+
     template<typename EvaluableT>
     class MultipleSqueezedExpressions;
 
@@ -244,6 +252,12 @@ namespace levi {
     template<typename GenericsMatrix, typename OutputMatrix>
     class CompiledEvaluable;
 
+    template<typename Scalar>
+    struct BatchView;
+
+    template<typename BaseType>
+    class CompiledCollection;
+
 
     /** Useful typedefs
      **/
@@ -0,0 +1,56 @@
+/*
+* Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+* Authors: Stefano Dafarra
+* CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+*
+*/
+#ifndef LEVI_KERNELREGISTRY_H
+#define LEVI_KERNELREGISTRY_H
+
+#include <string>
+#include <unordered_map>
+
+namespace levi {
+
+    /**
+     * @brief Compiled expressions generated ahead of time and linked in the executable, indexed by the name of their library.
+     *
+     * The sources are generated with the SourcesOnly compilation backend and added to a target with levi_add_generated_expressions.
+     * When an expression with the same name is compiled, the linked kernel is used if it has been generated from the same code.
+     */
+    template <typename BaseClass>
+    class KernelRegistry {
+    public:
+
+        struct Entry {
+            std::string signature; //Hash of the generated code
+            BaseClass* (*create)();
+        };
+
+        static std::unordered_map<std::string, Entry>& entries() {
+            static std::unordered_map<std::string, Entry> registeredEntries;
+            return registeredEntries;
+        }
+
+        static void add(const std::string& name, const std::string& signature, BaseClass* (*create)()) {
+            entries()[name] = {signature, create};
+        }
+
+        static const Entry* find(const std::string& name) {
+            typename std::unordered_map<std::string, Entry>::const_iterator entry = entries().find(name);
+            return (entry != entries().end()) ? &(entry->second) : nullptr;
+        }
+    };
+
+    /**
+     * @brief Adds a kernel to the registry when it is constructed. The generated sources define a static instance for each kernel.
+     */
+    template <typename BaseClass, typename KernelClass>
+    struct KernelRegistrar {
+        KernelRegistrar(const std::string& name, const std::string& signature) {
+            levi::KernelRegistry<BaseClass>::add(name, signature, []() -> BaseClass* { return new KernelClass(); });
+        }
+    };
+}
+
+#endif // LEVI_KERNELREGISTRY_H
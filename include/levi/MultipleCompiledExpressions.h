@@ -25,7 +25,8 @@ private:
 
     using SqueezedMatrix = typename levi::TreeComponent<EvaluableT>::SqueezedMatrix;
     using SqueezedMatrixRef = Eigen::Ref<SqueezedMatrix>;
-    using base_type = levi::CompiledEvaluable<SqueezedMatrixRef, std::vector<SqueezedMatrixRef>&>;
+    using GenericsMatrixRef = typename levi::AutogeneratedHelper<EvaluableT>::GenericsMatrixRef;
+    using base_type = levi::CompiledEvaluable<GenericsMatrixRef, std::vector<SqueezedMatrixRef>&>;
 
     std::vector<CompiledElement> m_elements;
     levi::AutogeneratedHelper<EvaluableT> m_helper;
@@ -36,7 +37,7 @@ private:
 
 public:
 
-    MultipleCompiledExpressions(const InputType& elements, const std::string& name) {
+    MultipleCompiledExpressions(const InputType& elements, const std::string& name, const levi::CompileOptions& options = levi::CompileOptions()) {
 
         std::vector<levi::ExpressionComponent<EvaluableT>> expressions;
 
@@ -46,9 +47,9 @@ public:
             m_resultsRef.emplace_back(m_results[element.first]);
         }
 
-        m_helper.setVariablesName("g", "h", "c");
+        m_helper.setVariablesName("g", "h", "c", "k");
 
-        m_helper.setExpressions(expressions, name);
+        m_helper.setExpressions(expressions, name, options);
 
         std::string cleanName = m_helper.name();
 
@@ -60,36 +61,44 @@ public:
         header << "#include<levi/CompiledEvaluable.h>" << std::endl << std::endl;
         header << "class " << cleanName << ": public " << type_name<base_type>() << " {" <<std::endl;
         header << "public:" << std::endl;
-        header << "    virtual void evaluate(const std::vector<" << type_name<SqueezedMatrixRef>() << ">& g, std::vector<"
+        header << "    virtual void evaluate(const std::vector<" << type_name<GenericsMatrixRef>() << ">& g, std::vector<"
                << type_name<SqueezedMatrixRef>() << ">& output) final;" << std::endl;
         header << "};" << std::endl;
         header << "#endif //LEVI_COMPILED"<< cleanName << "_H" << std::endl;
 
+        bool scalarized = m_helper.isScalarizable(levi::scalarizationMaximumSize());
+
+        std::vector<std::string> outputs;
+        for (size_t i = 0; i < expressions.size(); ++i) {
+            outputs.push_back("output[" + std::to_string(i) + "]");
+        }
+
         std::ostringstream cpp;
-        cpp << "void " << cleanName << "::evaluate(const std::vector<" << type_name<SqueezedMatrixRef>() << ">& g, std::vector<"
+        std::vector<std::string> kernelParts;
+        if (!scalarized) {
+            cpp << m_helper.getTypedKernel(cleanName + "Kernel");
+            kernelParts = m_helper.getTypedKernelParts(cleanName + "Kernel");
+        }
+        cpp << "void " << cleanName << "::evaluate(const std::vector<" << type_name<GenericsMatrixRef>() << ">& g, std::vector<"
             << type_name<SqueezedMatrixRef>() << ">& output) {" << std::endl;
-        cpp << m_helper.getHelpersDeclaration().str() << std::endl;
-        cpp << m_helper.getCommonsDeclaration().str() << std::endl;
 
-        for (size_t i = 0; i < expressions.size(); ++i) {
-            if (expressions[i].rows() == 1 && expressions[i].cols() == 1) {
-                cpp << "    output[" << std::to_string(i) << "](0, 0) = ";
-            } else {
-                cpp << "    output[" << std::to_string(i) << "] = ";
-            }
-            cpp << m_helper.getFinalExpressions()[i].str() << ";" << std::endl << std::endl;
+        if (scalarized) {
+            cpp << m_helper.getScalarizedCode(outputs);
+        } else {
+            cpp << m_helper.getTypedKernelCall(cleanName + "Kernel", outputs);
         }
 
         cpp << "}" << std::endl;
 
-        m_helper.compile(header.str(), cpp.str(), m_compiledEvaluable, cleanName);
+        m_helper.compile(header.str(), cpp.str(), m_compiledEvaluable, cleanName, kernelParts);
     }
 
     ~MultipleCompiledExpressions() { }
 
     const OutputType& evaluate() {
+        assert(m_compiledEvaluable.isValid() && "The expressions have not been compiled, since the SourcesOnly backend is in use.");
 
-        const std::vector<SqueezedMatrixRef>& generics = m_helper.evaluateGenerics();
+        const std::vector<GenericsMatrixRef>& generics = m_helper.evaluateGenerics();
         m_compiledEvaluable->evaluate(generics, m_resultsRef);
 
         return m_results;
@@ -30,77 +30,59 @@ private:
     std::unordered_map<size_t, std::string> m_indicesToNameMap;
     std::vector<levi::TreeComponent<EvaluableT>> m_expandedExpression;
     std::vector<size_t> m_generics;
+    std::vector<std::pair<size_t, typename EvaluableT::matrix_type*>> m_copiedOutputs; //Outputs which cannot be evaluated directly in m_results
     OutputType m_results;
+    levi::TreeSchedule m_schedule;
+    std::unique_ptr<levi::ThreadPool> m_threadPool;
 
 
 public:
 
-    MultipleSqueezedExpressions(const InputType& elements) {
+    MultipleSqueezedExpressions(const InputType& elements, size_t numberOfThreads = 1) {
+
+        levi::AddedExpressions alreadyAdded; //shared among the expressions, so that common subexpressions are evaluated once
 
         for (auto& element: elements) {
             m_indicesToNameMap[m_finalExpressionIndices.size()] = element.first;
-            m_finalExpressionIndices.emplace_back(levi::expandTree(element.second, true, m_expandedExpression, m_generics));
+            m_finalExpressionIndices.emplace_back(levi::expandTree(element.second, true, m_expandedExpression, m_generics, alreadyAdded));
             m_results[element.first] = SqueezedMatrix::Zero(element.second.rows(), element.second.cols());
         }
+
+        levi::fuseTree(m_expandedExpression, m_finalExpressionIndices);
+
+        if (numberOfThreads > 1) {
+            m_schedule = levi::scheduleTree(m_expandedExpression);
+            m_threadPool = std::make_unique<levi::ThreadPool>(numberOfThreads);
+        }
+
+        for (size_t i = 0; i < m_finalExpressionIndices.size(); ++i) {
+            levi::TreeComponent<EvaluableT>& finalComponent = m_expandedExpression[m_finalExpressionIndices[i]];
+            typename EvaluableT::matrix_type& result = m_results[m_indicesToNameMap[i]]; //elements of an unordered_map are never moved
+
+            if (finalComponent.isEvaluatedInTree() && !finalComponent.outputData) {
+                finalComponent.redirectOutput(result.data());
+            } else if (finalComponent.type == Type::Null || finalComponent.type == Type::Identity || finalComponent.type == Type::Constant) {
+                result = finalComponent.value();
+            } else {
+                m_copiedOutputs.emplace_back(m_finalExpressionIndices[i], &result); //generics or outputs shared with another name
+            }
+        }
+
+        levi::bindTreeViews(m_expandedExpression);
     }
 
     ~MultipleSqueezedExpressions() { }
 
     const OutputType& evaluate() {
 
-        for (size_t generic : m_generics) {
-            m_expandedExpression[generic].buffer = m_expandedExpression[generic].partialExpression.evaluate(); //first evaluate generics
-        }
-
-        levi::EvaluableType type;
-
-        for(typename std::vector<levi::TreeComponent<EvaluableT>>::iterator i = m_expandedExpression.begin();
-             i != m_expandedExpression.end(); ++i) {
-            type = i->type;
-
-            if (type == Type::Sum) {
-                i->buffer.lazyAssign(m_expandedExpression[i->lhsIndex].buffer + m_expandedExpression[i->rhsIndex].buffer); //this is why I need to evaluate the expanded expression in reverse order
-            } else if (type == Type::Subtraction) {
-                i->buffer.lazyAssign(m_expandedExpression[i->lhsIndex].buffer - m_expandedExpression[i->rhsIndex].buffer);
-            } else if (type == Type::Product) {
-
-                if (m_expandedExpression[i->lhsIndex].cols() != m_expandedExpression[i->rhsIndex].rows()) {
-                    if (m_expandedExpression[i->lhsIndex].rows() == 1 && m_expandedExpression[i->lhsIndex].cols() == 1) {
-                        i->buffer.lazyAssign(m_expandedExpression[i->lhsIndex].buffer(0,0) * m_expandedExpression[i->rhsIndex].buffer);
-                    } else {
-                        i->buffer.lazyAssign(m_expandedExpression[i->lhsIndex].buffer * m_expandedExpression[i->rhsIndex].buffer(0,0));
-                    }
-                } else {
-                    i->buffer.lazyAssign(m_expandedExpression[i->lhsIndex].buffer * m_expandedExpression[i->rhsIndex].buffer);
-                }
-
-            } else if (type == Type::Division) {
-                i->buffer.lazyAssign(m_expandedExpression[i->lhsIndex].buffer / m_expandedExpression[i->rhsIndex].buffer(0,0));
-            } else if (type == Type::InvertedSign) {
-                i->buffer.lazyAssign(-m_expandedExpression[i->lhsIndex].buffer);
-            } else if (type == Type::Pow) {
-                i->buffer(0,0) = std::pow(m_expandedExpression[i->lhsIndex].buffer(0,0), i->exponent);
-            } else if (type == Type::Transpose) {
-                i->buffer.lazyAssign(m_expandedExpression[i->lhsIndex].buffer.transpose());
-            } else if (type == Type::Row) {
-                i->buffer.lazyAssign(m_expandedExpression[i->lhsIndex].buffer.row(i->block.startRow));
-            } else if (type == Type::Column) {
-                i->buffer.lazyAssign(m_expandedExpression[i->lhsIndex].buffer.col(i->block.startCol));
-            } else if (type == Type::Element) {
-                i->buffer(0,0) = m_expandedExpression[i->lhsIndex].buffer(i->block.startRow, i->block.startCol);
-            } else if (type == Type::Block) {
-                i->buffer.lazyAssign(m_expandedExpression[i->lhsIndex].buffer.block(i->block.startRow, i->block.startCol, i->block.rows, i->block.cols));
-            } else if (type == Type::Horzcat) {
-                i->buffer.leftCols(m_expandedExpression[i->lhsIndex].cols()) = m_expandedExpression[i->lhsIndex].buffer;
-                i->buffer.rightCols(m_expandedExpression[i->rhsIndex].cols()) = m_expandedExpression[i->rhsIndex].buffer;
-            } else if (type == Type::Vertcat) {
-                i->buffer.topRows(m_expandedExpression[i->lhsIndex].rows()) = m_expandedExpression[i->lhsIndex].buffer;
-                i->buffer.bottomRows(m_expandedExpression[i->rhsIndex].rows()) = m_expandedExpression[i->rhsIndex].buffer;
-            }
+        if (m_threadPool) {
+            levi::evaluateTree(m_expandedExpression, m_generics, m_schedule, *m_threadPool);
+        } else {
+            levi::evaluateTree(m_expandedExpression, m_generics);
         }
 
-        for (size_t i = 0; i < m_finalExpressionIndices.size(); ++i) {
-            m_results[m_indicesToNameMap[i]] = m_expandedExpression[m_finalExpressionIndices[i]].buffer;
+        for (auto& copiedOutput : m_copiedOutputs) {
+            *(copiedOutput.second) = m_expandedExpression[copiedOutput.first].value();
         }
 
         return m_results;
@@ -0,0 +1,141 @@
+/*
+* Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+* Authors: Stefano Dafarra
+* CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+*
+*/
+#ifndef LEVI_THREADPOOL_H
+#define LEVI_THREADPOOL_H
+
+#include <levi/HelpersForwardDeclarations.h>
+#include <levi/ForwardDeclarations.h>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+
+/**
+ * @brief Persistent pool of threads used to run parallel loops.
+ *
+ * The threads are created once and wait for work between two calls of parallelFor. The calling thread takes part in the loop too.
+ */
+class levi::ThreadPool {
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_workDone;
+
+    const std::function<void(size_t)>* m_job;
+    size_t m_jobSize;
+    std::atomic<size_t> m_nextIndex;
+    size_t m_runningWorkers;
+    size_t m_generation;
+    bool m_stop;
+
+    void runJob() {
+        //Indices are assigned dynamically, so that threads that finish early take the remaining work
+        for (size_t i = m_nextIndex++; i < m_jobSize; i = m_nextIndex++) {
+            (*m_job)(i);
+        }
+    }
+
+    void workerLoop() {
+        size_t lastGeneration = 0;
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_workAvailable.wait(lock, [this, lastGeneration](){return m_stop || (m_generation != lastGeneration);});
+
+                if (m_stop) {
+                    return;
+                }
+
+                lastGeneration = m_generation;
+            }
+
+            runJob();
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_runningWorkers--;
+                if (m_runningWorkers == 0) {
+                    m_workDone.notify_one();
+                }
+            }
+        }
+    }
+
+public:
+
+    /**
+     * @brief Constructor
+     * @param numberOfThreads The number of threads running a loop, including the calling one.
+     */
+    ThreadPool(size_t numberOfThreads)
+        : m_job(nullptr)
+        , m_jobSize(0)
+        , m_nextIndex(0)
+        , m_runningWorkers(0)
+        , m_generation(0)
+        , m_stop(false)
+    {
+        assert(numberOfThreads > 0 && "The number of threads should be at least 1.");
+
+        for (size_t i = 1; i < numberOfThreads; ++i) {
+            m_workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool(const ThreadPool& other) = delete;
+
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_workAvailable.notify_all();
+
+        for (std::thread& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    size_t numberOfThreads() const {
+        return m_workers.size() + 1;
+    }
+
+    /**
+     * @brief Calls job(i) for each i in [0, size), returning when all the calls are completed.
+     */
+    void parallelFor(size_t size, const std::function<void(size_t)>& job) {
+
+        if (m_workers.empty() || size < 2) {
+            for (size_t i = 0; i < size; ++i) {
+                job(i);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_job = &job;
+            m_jobSize = size;
+            m_nextIndex = 0;
+            m_runningWorkers = m_workers.size();
+            m_generation++;
+        }
+        m_workAvailable.notify_all();
+
+        runJob();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_workDone.wait(lock, [this](){return m_runningWorkers == 0;});
+    }
+
+};
+
+#endif // LEVI_THREADPOOL_H
@@ -11,11 +11,82 @@
 #include <levi/ForwardDeclarations.h>
 #include <levi/Expression.h>
 #include <levi/TypeDetector.h>
-#include <map>
+#include <levi/ThreadPool.h>
+#include <unordered_map>
+#include <functional>
 
 namespace levi {
 
-    typedef std::map<levi::EvaluableType, std::vector<size_t>> AddedExpressions;
+    /**
+     * @brief Structural identity of a component of the expanded tree.
+     *
+     * Operators are identified by their type, the indices of their (already expanded) operands and their parameters.
+     * Leaves are identified by the hash of their evaluable, apart from Null and Identity which depend only on their size.
+     */
+    struct TreeComponentKey {
+        levi::EvaluableType type;
+        size_t lhs = 0;
+        size_t rhs = 0;
+        Eigen::Index rows = 0;
+        Eigen::Index cols = 0;
+        levi::BlockType block;
+        double exponent = 0;
+
+        bool operator==(const TreeComponentKey& other) const {
+            return (type == other.type) && (lhs == other.lhs) && (rhs == other.rhs) && (rows == other.rows) &&
+                    (cols == other.cols) && (block == other.block) && (exponent == other.exponent);
+        }
+    };
+
+    struct TreeComponentKeyHash {
+        size_t operator()(const TreeComponentKey& key) const {
+            size_t seed = static_cast<size_t>(key.type);
+            auto combine = [&seed](size_t value) {
+                seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+            };
+            combine(key.lhs);
+            combine(key.rhs);
+            combine(static_cast<size_t>(key.rows));
+            combine(static_cast<size_t>(key.cols));
+            combine(static_cast<size_t>(key.block.startRow));
+            combine(static_cast<size_t>(key.block.startCol));
+            combine(static_cast<size_t>(key.block.rows));
+            combine(static_cast<size_t>(key.block.cols));
+            combine(std::hash<double>()(key.exponent));
+            return seed;
+        }
+    };
+
+    /**
+     * @brief Components already added to an expanded tree.
+     *
+     * It can be shared among several calls of expandTree on the same expanded tree, so that common nodes are added only once.
+     */
+    struct AddedExpressions {
+        std::unordered_map<size_t, size_t> evaluables; //From the hash of an evaluable to its index in the expanded tree
+        std::unordered_map<TreeComponentKey, size_t, TreeComponentKeyHash> components; //From the structure of a component to its index in the expanded tree
+    };
+
+    /**
+     * @brief Kernel used to evaluate a component of a squeezed tree.
+     */
+    enum class TreeKernel {
+        Default, //Evaluated according to its type
+        Absorbed, //Evaluated by the (only) component using it
+        FusedProduct, //output = addendSign * addend + productSign * op(lhs) * op(rhs), where op may be a transposition
+        ScaledSum, //output = productSign * lhs(0,0) * rhs + addendSign * addend
+        View //Accessor whose value is read directly from the memory of its operand
+    };
+
+    /**
+     * @brief Partition in dependency levels of the components evaluated in an expanded tree.
+     *
+     * The components of a level depend only on components of the previous levels, hence they can be evaluated concurrently.
+     */
+    struct TreeSchedule {
+        std::vector<std::vector<size_t>> levels;
+        std::vector<bool> parallelLevels; //Levels with enough work to be split among threads
+    };
 
     template<typename EvaluableT>
     size_t expandTree(const levi::ExpressionComponent<levi::Evaluable<Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic>>>& node,
@@ -28,6 +99,25 @@ namespace levi {
                       bool expandForSqueeze,
                       std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression,
                       std::vector<size_t>& generics, AddedExpressions& alreadyAdded);
+
+    template<typename EvaluableT>
+    void fuseTree(std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression, const std::vector<size_t>& outputs);
+
+    template<typename EvaluableT>
+    void bindTreeViews(std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression);
+
+    template<typename EvaluableT>
+    levi::TreeSchedule scheduleTree(const std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression, double minimumParallelCost = 20000.0);
+
+    template<typename EvaluableT>
+    void evaluateTreeComponent(std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression, size_t index);
+
+    template<typename EvaluableT>
+    void evaluateTree(std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression, const std::vector<size_t>& generics);
+
+    template<typename EvaluableT>
+    void evaluateTree(std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression, const std::vector<size_t>& generics,
+                      const levi::TreeSchedule& schedule, levi::ThreadPool& pool);
 }
 
 template<typename EvaluableT>
@@ -37,10 +127,13 @@ class levi::TreeComponent {
 
     Eigen::Index m_rows;
     Eigen::Index m_cols;
+    Eigen::Index m_outerStride; //Distance between two columns in the memory where the component is stored
 
 public:
 
     typedef Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic> SqueezedMatrix;
+    typedef Eigen::Map<SqueezedMatrix, 0, Eigen::OuterStride<>> SqueezedMatrixMap;
+    typedef Eigen::Map<const SqueezedMatrix, 0, Eigen::OuterStride<>> SqueezedMatrixConstMap;
 
     levi::ExpressionComponent<levi::Evaluable<SqueezedMatrix>> partialExpression;
 
@@ -54,19 +147,43 @@ public:
     levi::BlockType block;
     typename EvaluableT::value_type exponent;
 
+    const typename EvaluableT::value_type* valueData; //If not null, the value of the component is read from here instead of buffer (e.g. the evaluation buffer of a generic)
+    typename EvaluableT::value_type* outputData; //If not null, the component is evaluated directly in this memory instead of buffer
+
+    //Set by fuseTree. With a fused kernel, lhsIndex and rhsIndex refer to the operands of the fused product.
+    levi::TreeKernel kernel;
+    bool lhsTransposed;
+    bool rhsTransposed;
+    bool hasAddend;
+    size_t addendIndex;
+    typename EvaluableT::value_type productSign;
+    typename EvaluableT::value_type addendSign;
+
+    //Set by bindTreeViews. The operands of a concatenation may be evaluated directly in its memory.
+    bool lhsInPlace;
+    bool rhsInPlace;
+
 
     TreeComponent(const levi::ExpressionComponent<levi::Evaluable<SqueezedMatrix>>& expression, bool expandForSqueeze)
         : partialExpression(expression)
           , type(expression.info().type)
           , m_rows(expression.rows())
           , m_cols(expression.cols())
+          , m_outerStride(std::max<Eigen::Index>(expression.rows(), 1))
           , lhsIndex(0)
           , rhsIndex(0)
+          , valueData(nullptr)
+          , outputData(nullptr)
+          , kernel(levi::TreeKernel::Default)
+          , lhsTransposed(false)
+          , rhsTransposed(false)
+          , hasAddend(false)
+          , addendIndex(0)
+          , productSign(1)
+          , addendSign(1)
+          , lhsInPlace(false)
+          , rhsInPlace(false)
     {
-        if (!expandForSqueeze && (type == Type::Null || type == Type::Identity || type == Type::Constant || type == Type::Horzcat || type == Type::Vertcat)) {
-            type = Type::Generic; //This is supposed to be a temporary fix for evaluables not yet supported by autogeneration
-        }
-
         if (expandForSqueeze || type == Type::Generic) {
             buffer.resize(expression.rows(), expression.cols());
 
@@ -97,6 +214,54 @@ public:
         return m_cols;
     }
 
+    Eigen::Index outerStride() const {
+        return m_outerStride;
+    }
+
+    SqueezedMatrixConstMap value() const {
+        return SqueezedMatrixConstMap(valueData ? valueData : buffer.data(), m_rows, m_cols, Eigen::OuterStride<>(m_outerStride));
+    }
+
+    SqueezedMatrixMap output() {
+        return SqueezedMatrixMap(outputData ? outputData : buffer.data(), m_rows, m_cols, Eigen::OuterStride<>(m_outerStride));
+    }
+
+    bool isLeaf() const {
+        return (type == Type::Generic) || (type == Type::Null) || (type == Type::Identity) || (type == Type::Constant);
+    }
+
+    bool isEvaluatedInTree() const {
+        return !isLeaf();
+    }
+
+    bool isBinary() const {
+        return (type == Type::Sum) || (type == Type::Subtraction) || (type == Type::Product) ||
+                (type == Type::Division) || (type == Type::Horzcat) || (type == Type::Vertcat);
+    }
+
+    bool isMatrixProduct(const std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression) const {
+        return (type == Type::Product) && (expandedExpression[lhsIndex].cols() == expandedExpression[rhsIndex].rows());
+    }
+
+    //Redirect the output of the component to an external memory of the same size. Only components evaluated in the tree can be redirected.
+    void redirectOutput(typename EvaluableT::value_type* destination) {
+        redirectOutput(destination, std::max<Eigen::Index>(m_rows, 1));
+    }
+
+    //Redirect the output of the component to a block of a larger matrix, whose columns are outerStride elements apart.
+    void redirectOutput(typename EvaluableT::value_type* destination, Eigen::Index outerStride) {
+        assert(isEvaluatedInTree());
+        outputData = destination;
+        valueData = destination;
+        m_outerStride = outerStride;
+    }
+
+    //Read the value of the component from the memory of another component, without copying it.
+    void setView(const typename EvaluableT::value_type* source, Eigen::Index outerStride) {
+        valueData = source;
+        m_outerStride = outerStride;
+    }
+
 };
 
 template<typename EvaluableT>
@@ -115,97 +280,470 @@ size_t levi::expandTree(const levi::ExpressionComponent<levi::Evaluable<Eigen::M
                         std::vector<size_t>& generics, levi::AddedExpressions& alreadyAdded) {
 
     using Type = levi::EvaluableType;
+    using NodeType = levi::ExpressionComponent<levi::Evaluable<Eigen::Matrix<typename EvaluableT::value_type, Eigen::Dynamic, Eigen::Dynamic>>>;
+
+    struct StackElement {
+        const NodeType* node;
+        bool operandsExpanded;
+    };
 
     //Returns the position in which the node has been saved
     assert(node.isValidExpression());
 
-    levi::EvaluableType type;
+    //The tree is visited in depth-first order with an explicit stack. The lhs is always expanded before the rhs.
+    std::vector<StackElement> stack;
+    stack.push_back({&node, false});
+
+    while (stack.size()) {
+        const NodeType& current = *(stack.back().node);
+        size_t evaluableHash = current.info().hash;
+
+        if (alreadyAdded.evaluables.find(evaluableHash) != alreadyAdded.evaluables.end()) {
+            stack.pop_back(); //The same evaluable has already been expanded
+            continue;
+        }
+
+        Type type = current.info().type;
+        bool isLeaf = (type == Type::Generic || type == Type::Null || type == Type::Identity || type == Type::Constant);
+        bool isBinary = (type == Type::Sum || type == Type::Subtraction || type == Type::Product ||
+                         type == Type::Division || type == Type::Vertcat || type == Type::Horzcat);
+        levi::TreeComponentKey key;
+        key.type = current.info().type;
+        key.rows = current.rows();
+        key.cols = current.cols();
+
+        if (isLeaf) {
+            if (key.type != Type::Null && key.type != Type::Identity) {
+                key.lhs = evaluableHash;
+            }
+        } else {
+            assert((isBinary || type == Type::InvertedSign || type == Type::Pow || type == Type::Transpose || type == Type::Row ||
+                    type == Type::Column || type == Type::Element || type == Type::Block) && "Case not considered.");
+
+            if (!stack.back().operandsExpanded) {
+                stack.back().operandsExpanded = true;
+                if (isBinary) {
+                    stack.push_back({&(current.info().rhs), false});
+                }
+                stack.push_back({&(current.info().lhs), false});
+                continue;
+            }
+
+            key.lhs = alreadyAdded.evaluables[current.info().lhs.info().hash];
+
+            if (isBinary) {
+                key.rhs = alreadyAdded.evaluables[current.info().rhs.info().hash];
+
+                if (type == Type::Sum && key.rhs < key.lhs) {
+                    std::swap(key.lhs, key.rhs); //The sum is commutative
+                }
+            }
+
+            if (type == Type::Row || type == Type::Column || type == Type::Element || type == Type::Block) {
+                key.block = current.info().block;
+            }
+
+            if (type == Type::Pow) {
+                key.exponent = static_cast<double>(current.info().exponent);
+            }
+        }
+
+        typename std::unordered_map<levi::TreeComponentKey, size_t, levi::TreeComponentKeyHash>::iterator sameComponent = alreadyAdded.components.find(key);
+
+        if (sameComponent != alreadyAdded.components.end()) {
+            alreadyAdded.evaluables[evaluableHash] = sameComponent->second; //An equivalent component has been added before
+        } else {
+            size_t currentIndex = expandedExpression.size();
+            expandedExpression.emplace_back(current, expandForSqueeze);
+
+            if (type == Type::Generic) {
+                generics.push_back(currentIndex);
+            } else if (!isLeaf) {
+                expandedExpression.back().lhsIndex = alreadyAdded.evaluables[current.info().lhs.info().hash];
+                if (isBinary) {
+                    expandedExpression.back().rhsIndex = alreadyAdded.evaluables[current.info().rhs.info().hash];
+                }
+            }
+
+            alreadyAdded.components[key] = currentIndex;
+            alreadyAdded.evaluables[evaluableHash] = currentIndex;
+        }
+
+        stack.pop_back();
+    }
+
+    return alreadyAdded.evaluables[node.info().hash];
+}
 
-    levi::TreeComponent<EvaluableT> newComponent(node, expandForSqueeze);
+template<typename EvaluableT>
+void levi::fuseTree(std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression, const std::vector<size_t>& outputs) {
 
-    type = newComponent.type;
+    using Type = levi::EvaluableType;
+    using Kernel = levi::TreeKernel;
 
-    size_t currentIndex = expandedExpression.size();
+    //Count how many times each component is used. Outputs cannot be absorbed since their value is read after the evaluation.
+    std::vector<size_t> uses(expandedExpression.size(), 0);
 
-    if (type == Type::Generic) {
-        for (size_t generic : generics) {
-            if (expandedExpression[generic].partialExpression == newComponent.partialExpression) {
-                // This is the case where the same Generic has been added before.
-                return generic;
+    for (const levi::TreeComponent<EvaluableT>& component : expandedExpression) {
+        if (component.isEvaluatedInTree()) {
+            uses[component.lhsIndex]++;
+            if (component.isBinary()) {
+                uses[component.rhsIndex]++;
             }
         }
-        expandedExpression.push_back(newComponent);
-        currentIndex = expandedExpression.size() - 1;
-        generics.push_back(currentIndex);
-        return currentIndex;
     }
 
-    if (type == Type::Null || type == Type::Identity || type == Type::Constant) {
-        expandedExpression.push_back(newComponent);
-        currentIndex = expandedExpression.size() - 1;
-        return currentIndex;
+    for (size_t output : outputs) {
+        uses[output]++;
     }
 
-    if (type == Type::Sum || type == Type::Subtraction || type == Type::Product ||
-        type == Type::Division || type == Type::Vertcat || type == Type::Horzcat) {
-        size_t lhsIndex = expandTree(node.info().lhs, expandForSqueeze, expandedExpression, generics, alreadyAdded);
-        newComponent.lhsIndex = lhsIndex;
-        size_t rhsIndex = expandTree(node.info().rhs, expandForSqueeze, expandedExpression, generics, alreadyAdded);
-        newComponent.rhsIndex = rhsIndex;
+    auto canBeAbsorbed = [&](size_t index, Kernel kernel) {
+        const levi::TreeComponent<EvaluableT>& component = expandedExpression[index];
+        return (uses[index] == 1) && (component.kernel == kernel) && !component.hasAddend;
+    };
+
+    auto absorbProduct = [&](levi::TreeComponent<EvaluableT>& component, size_t productIndex, typename EvaluableT::value_type sign) {
+        levi::TreeComponent<EvaluableT>& product = expandedExpression[productIndex];
+        component.kernel = Kernel::FusedProduct;
+        component.lhsIndex = product.lhsIndex;
+        component.rhsIndex = product.rhsIndex;
+        component.lhsTransposed = product.lhsTransposed;
+        component.rhsTransposed = product.rhsTransposed;
+        component.productSign = sign * product.productSign;
+        product.kernel = Kernel::Absorbed;
+    };
+
+    //Components are sorted such that the operands come before the components using them
+    for (levi::TreeComponent<EvaluableT>& component : expandedExpression) {
+        Type type = component.type;
+
+        if (component.isMatrixProduct(expandedExpression)) {
+            component.kernel = Kernel::FusedProduct; //A^T * B is computed without materializing A^T
+
+            if (expandedExpression[component.lhsIndex].type == Type::Transpose && canBeAbsorbed(component.lhsIndex, Kernel::Default)) {
+                expandedExpression[component.lhsIndex].kernel = Kernel::Absorbed;
+                component.lhsIndex = expandedExpression[component.lhsIndex].lhsIndex;
+                component.lhsTransposed = true;
+            }
 
-        if (lhsIndex < currentIndex && rhsIndex < currentIndex) { //This means that both the lhs and the rhs were added before
-            bool isNew = true;
-            size_t i = 0;
+            if (expandedExpression[component.rhsIndex].type == Type::Transpose && canBeAbsorbed(component.rhsIndex, Kernel::Default)) {
+                expandedExpression[component.rhsIndex].kernel = Kernel::Absorbed;
+                component.rhsIndex = expandedExpression[component.rhsIndex].lhsIndex;
+                component.rhsTransposed = true;
+            }
 
-            std::vector<size_t>& others = alreadyAdded[type];
+        } else if (type == Type::InvertedSign) {
 
-            while (isNew && i < others.size()) {
-                isNew = isNew && (expandedExpression[others[i]].partialExpression != newComponent.partialExpression);
-                ++i;
+            if (canBeAbsorbed(component.lhsIndex, Kernel::FusedProduct)) {
+                absorbProduct(component, component.lhsIndex, -1); //-(A * B)
             }
 
-            if (!isNew) {
-                return others[i-1];
+        } else if (type == Type::Sum || type == Type::Subtraction) {
+            size_t lhs = component.lhsIndex, rhs = component.rhsIndex;
+            typename EvaluableT::value_type rhsSign = (type == Type::Sum) ? 1 : -1;
+
+            if (canBeAbsorbed(lhs, Kernel::FusedProduct)) { //A * x + b
+                absorbProduct(component, lhs, 1);
+                component.addendIndex = rhs;
+                component.addendSign = rhsSign;
+                component.hasAddend = true;
+            } else if (canBeAbsorbed(rhs, Kernel::FusedProduct)) { //b + A * x
+                absorbProduct(component, rhs, rhsSign);
+                component.addendIndex = lhs;
+                component.hasAddend = true;
+            } else {
+                bool lhsScaled = (expandedExpression[lhs].type == Type::Product) && canBeAbsorbed(lhs, Kernel::Default);
+                bool rhsScaled = (expandedExpression[rhs].type == Type::Product) && canBeAbsorbed(rhs, Kernel::Default);
+
+                if (lhsScaled || rhsScaled) { //s * A + B
+                    size_t productIndex = lhsScaled ? lhs : rhs;
+                    levi::TreeComponent<EvaluableT>& product = expandedExpression[productIndex];
+                    bool scalarOnLeft = (expandedExpression[product.lhsIndex].rows() == 1) && (expandedExpression[product.lhsIndex].cols() == 1);
+
+                    component.kernel = Kernel::ScaledSum;
+                    component.lhsIndex = scalarOnLeft ? product.lhsIndex : product.rhsIndex;
+                    component.rhsIndex = scalarOnLeft ? product.rhsIndex : product.lhsIndex;
+                    component.productSign = lhsScaled ? 1 : rhsSign;
+                    component.addendIndex = lhsScaled ? rhs : lhs;
+                    component.addendSign = lhsScaled ? rhsSign : 1;
+                    component.hasAddend = true;
+                    product.kernel = Kernel::Absorbed;
+                }
             }
+        }
+    }
 
+    for (levi::TreeComponent<EvaluableT>& component : expandedExpression) {
+        if (component.kernel == Kernel::Absorbed) {
+            component.buffer.resize(0, 0); //Its value is never stored
         }
+    }
+}
+
+template<typename EvaluableT>
+void levi::bindTreeViews(std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression) {
 
-        expandedExpression.push_back(newComponent);
-        currentIndex = expandedExpression.size() - 1;
-        alreadyAdded[type].push_back(currentIndex);
-        return currentIndex;
+    using Type = levi::EvaluableType;
+    using Kernel = levi::TreeKernel;
+
+    //Accessors become views on the memory of their operand. A transposition can be a view only if its operand is a column,
+    //since the columns of a component are contiguous in memory.
+    for (levi::TreeComponent<EvaluableT>& component : expandedExpression) {
+        Type type = component.type;
+
+        if (component.kernel != Kernel::Default || component.outputData) {
+            continue; //The outputs have to be evaluated in their own memory
+        }
+
+        if (type == Type::Row || type == Type::Column || type == Type::Element || type == Type::Block ||
+                (type == Type::Transpose && expandedExpression[component.lhsIndex].cols() == 1)) {
+            component.kernel = Kernel::View;
+            component.buffer.resize(0, 0);
+        }
+    }
+
+    //The operands of a concatenation are evaluated directly in the corresponding block. Concatenations are visited from the last one,
+    //so that a concatenation nested in another one is redirected before its operands are.
+    for (size_t i = expandedExpression.size(); i-- > 0;) {
+        levi::TreeComponent<EvaluableT>& component = expandedExpression[i];
+
+        if (component.type != Type::Horzcat && component.type != Type::Vertcat) {
+            continue;
+        }
+
+        auto evaluateInPlace = [&component, &expandedExpression](size_t operandIndex, Eigen::Index rowOffset, Eigen::Index colOffset) {
+            levi::TreeComponent<EvaluableT>& operand = expandedExpression[operandIndex];
+
+            if (!operand.isEvaluatedInTree() || operand.kernel == Kernel::Absorbed || operand.kernel == Kernel::View || operand.outputData) {
+                return false;
+            }
+
+            operand.redirectOutput(component.output().data() + rowOffset + colOffset * component.outerStride(), component.outerStride());
+            operand.buffer.resize(0, 0);
+            return true;
+        };
+
+        const levi::TreeComponent<EvaluableT>& lhs = expandedExpression[component.lhsIndex];
+        component.lhsInPlace = evaluateInPlace(component.lhsIndex, 0, 0);
+
+        if (component.type == Type::Horzcat) {
+            component.rhsInPlace = evaluateInPlace(component.rhsIndex, 0, lhs.cols());
+        } else {
+            component.rhsInPlace = evaluateInPlace(component.rhsIndex, lhs.rows(), 0);
+        }
+    }
+}
+
+template<typename EvaluableT>
+levi::TreeSchedule levi::scheduleTree(const std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression, double minimumParallelCost) {
+
+    using Kernel = levi::TreeKernel;
+
+    levi::TreeSchedule schedule;
+    std::vector<size_t> componentLevels(expandedExpression.size(), 0); //Leaves are at level 0, they are not evaluated in the tree
+    std::vector<double> levelCosts;
+
+    for (size_t i = 0; i < expandedExpression.size(); ++i) {
+        const levi::TreeComponent<EvaluableT>& component = expandedExpression[i];
+
+        if (!component.isEvaluatedInTree() || component.kernel == Kernel::Absorbed) {
+            continue;
+        }
+
+        size_t level = componentLevels[component.lhsIndex];
+        //Rough estimate of the number of operations, used to decide whether a level is worth splitting
+        double cost = static_cast<double>(component.rows() * component.cols());
+
+        if (component.kernel != Kernel::Default || component.isBinary()) {
+            level = std::max(level, componentLevels[component.rhsIndex]);
+        }
+
+        if (component.hasAddend) {
+            level = std::max(level, componentLevels[component.addendIndex]);
+        }
+
+        if (component.kernel == Kernel::FusedProduct) {
+            const levi::TreeComponent<EvaluableT>& lhs = expandedExpression[component.lhsIndex];
+            cost *= static_cast<double>(component.lhsTransposed ? lhs.rows() : lhs.cols());
+        } else if (component.kernel == Kernel::Default && component.isMatrixProduct(expandedExpression)) {
+            cost *= static_cast<double>(expandedExpression[component.lhsIndex].cols());
+        }
+
+        level++;
+        componentLevels[i] = level;
+
+        if (schedule.levels.size() < level) {
+            schedule.levels.resize(level);
+            levelCosts.resize(level, 0.0);
+        }
+
+        schedule.levels[level - 1].push_back(i);
+        levelCosts[level - 1] += cost;
+    }
+
+    schedule.parallelLevels.resize(schedule.levels.size());
+
+    for (size_t l = 0; l < schedule.levels.size(); ++l) {
+        schedule.parallelLevels[l] = (schedule.levels[l].size() > 1) && (levelCosts[l] >= minimumParallelCost);
+    }
+
+    return schedule;
+}
+
+namespace levi {
+
+    template<typename OutputType, typename LhsType, typename RhsType, typename Scalar>
+    void evaluateFusedProduct(OutputType& output, const LhsType& lhs, const RhsType& rhs, Scalar productSign, bool accumulate) {
+        if (!accumulate) {
+            if (productSign > 0) {
+                output.noalias() = lhs * rhs;
+            } else {
+                output.noalias() = (-lhs) * rhs;
+            }
+        } else if (productSign > 0) {
+            output.noalias() += lhs * rhs;
+        } else {
+            output.noalias() -= lhs * rhs;
+        }
     }
 
-    if (type == Type::InvertedSign || type == Type::Pow || type == Type::Transpose || type == Type::Row ||
-        type == Type::Column || type == Type::Element || type == Type::Block) {
-        size_t lhsIndex = expandTree(node.info().lhs, expandForSqueeze, expandedExpression, generics, alreadyAdded);
-        newComponent.lhsIndex = lhsIndex;
+}
 
-        if (lhsIndex < currentIndex) { //This means that the lhs was already before
-            bool isNew = true;
-            size_t i = 0;
+template<typename EvaluableT>
+void levi::evaluateTreeComponent(std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression, size_t index) {
+
+    using Type = levi::EvaluableType;
 
-            std::vector<size_t>& others = alreadyAdded[type];
+    levi::TreeComponent<EvaluableT>& component = expandedExpression[index];
+    levi::EvaluableType type = component.type;
 
-            while (isNew && i < others.size()) {
-                isNew = isNew && (expandedExpression[others[i]].partialExpression != newComponent.partialExpression);
-                ++i;
+    if (component.kernel == levi::TreeKernel::Absorbed) {
+        return;
+    }
+
+    if (component.kernel == levi::TreeKernel::View) {
+        const levi::TreeComponent<EvaluableT>& operand = expandedExpression[component.lhsIndex];
+        const typename EvaluableT::value_type* operandData = operand.value().data();
+        Eigen::Index operandStride = operand.outerStride();
+
+        if (type == Type::Transpose) {
+            component.setView(operandData, 1); //The transpose of a column is a row with contiguous elements
+        } else if (type == Type::Row) {
+            component.setView(operandData + component.block.startRow, operandStride);
+        } else if (type == Type::Column) {
+            component.setView(operandData + component.block.startCol * operandStride, operandStride);
+        } else {
+            component.setView(operandData + component.block.startRow + component.block.startCol * operandStride, operandStride);
+        }
+        return;
+    }
+
+    if (component.kernel == levi::TreeKernel::FusedProduct) {
+        typename levi::TreeComponent<EvaluableT>::SqueezedMatrixMap output = component.output();
+        typename levi::TreeComponent<EvaluableT>::SqueezedMatrixConstMap lhs = expandedExpression[component.lhsIndex].value();
+        typename levi::TreeComponent<EvaluableT>::SqueezedMatrixConstMap rhs = expandedExpression[component.rhsIndex].value();
+
+        if (component.hasAddend) {
+            if (component.addendSign > 0) {
+                output = expandedExpression[component.addendIndex].value();
+            } else {
+                output = -expandedExpression[component.addendIndex].value();
             }
+        }
+
+        if (component.lhsTransposed && component.rhsTransposed) {
+            levi::evaluateFusedProduct(output, lhs.transpose(), rhs.transpose(), component.productSign, component.hasAddend);
+        } else if (component.lhsTransposed) {
+            levi::evaluateFusedProduct(output, lhs.transpose(), rhs, component.productSign, component.hasAddend);
+        } else if (component.rhsTransposed) {
+            levi::evaluateFusedProduct(output, lhs, rhs.transpose(), component.productSign, component.hasAddend);
+        } else {
+            levi::evaluateFusedProduct(output, lhs, rhs, component.productSign, component.hasAddend);
+        }
 
-            if (!isNew) {
-                return others[i-1];
+    } else if (component.kernel == levi::TreeKernel::ScaledSum) {
+        component.output().noalias() = (component.productSign * expandedExpression[component.lhsIndex].value()(0,0)) * expandedExpression[component.rhsIndex].value() +
+                component.addendSign * expandedExpression[component.addendIndex].value();
+    } else if (type == Type::Sum) {
+        component.output().noalias() = expandedExpression[component.lhsIndex].value() + expandedExpression[component.rhsIndex].value();
+    } else if (type == Type::Subtraction) {
+        component.output().noalias() = expandedExpression[component.lhsIndex].value() - expandedExpression[component.rhsIndex].value();
+    } else if (type == Type::Product) {
+
+        if (expandedExpression[component.lhsIndex].cols() != expandedExpression[component.rhsIndex].rows()) {
+            if (expandedExpression[component.lhsIndex].rows() == 1 && expandedExpression[component.lhsIndex].cols() == 1) {
+                component.output().noalias() = expandedExpression[component.lhsIndex].value()(0,0) * expandedExpression[component.rhsIndex].value();
+            } else {
+                component.output().noalias() = expandedExpression[component.lhsIndex].value() * expandedExpression[component.rhsIndex].value()(0,0);
             }
+        } else {
+            component.output().noalias() = expandedExpression[component.lhsIndex].value() * expandedExpression[component.rhsIndex].value();
+        }
 
+    } else if (type == Type::Division) {
+        component.output().noalias() = expandedExpression[component.lhsIndex].value() / expandedExpression[component.rhsIndex].value()(0,0);
+    } else if (type == Type::InvertedSign) {
+        component.output().noalias() = -expandedExpression[component.lhsIndex].value();
+    } else if (type == Type::Pow) {
+        component.output()(0,0) = levi::power(expandedExpression[component.lhsIndex].value()(0,0), component.exponent);
+    } else if (type == Type::Transpose) {
+        component.output().noalias() = expandedExpression[component.lhsIndex].value().transpose();
+    } else if (type == Type::Row) {
+        component.output().noalias() = expandedExpression[component.lhsIndex].value().row(component.block.startRow);
+    } else if (type == Type::Column) {
+        component.output().noalias() = expandedExpression[component.lhsIndex].value().col(component.block.startCol);
+    } else if (type == Type::Element) {
+        component.output()(0,0) = expandedExpression[component.lhsIndex].value()(component.block.startRow, component.block.startCol);
+    } else if (type == Type::Block) {
+        component.output().noalias() = expandedExpression[component.lhsIndex].value().block(component.block.startRow, component.block.startCol, component.block.rows, component.block.cols);
+    } else if (type == Type::Horzcat) {
+        if (!component.lhsInPlace) {
+            component.output().leftCols(expandedExpression[component.lhsIndex].cols()) = expandedExpression[component.lhsIndex].value();
+        }
+        if (!component.rhsInPlace) {
+            component.output().rightCols(expandedExpression[component.rhsIndex].cols()) = expandedExpression[component.rhsIndex].value();
+        }
+    } else if (type == Type::Vertcat) {
+        if (!component.lhsInPlace) {
+            component.output().topRows(expandedExpression[component.lhsIndex].rows()) = expandedExpression[component.lhsIndex].value();
         }
+        if (!component.rhsInPlace) {
+            component.output().bottomRows(expandedExpression[component.rhsIndex].rows()) = expandedExpression[component.rhsIndex].value();
+        }
+    }
+}
+
+template<typename EvaluableT>
+void levi::evaluateTree(std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression, const std::vector<size_t>& generics) {
 
-        expandedExpression.push_back(newComponent);
-        currentIndex = expandedExpression.size() - 1;
-        alreadyAdded[type].push_back(currentIndex);
-        return currentIndex;
+    for (size_t generic : generics) {
+        expandedExpression[generic].valueData = expandedExpression[generic].partialExpression.evaluate().data(); //first evaluate generics, reading them from their own buffer
     }
 
-    assert(false && "Case not considered.");
-    return expandedExpression.size();
+    for (size_t i = 0; i < expandedExpression.size(); ++i) {
+        levi::evaluateTreeComponent(expandedExpression, i);
+    }
+}
+
+template<typename EvaluableT>
+void levi::evaluateTree(std::vector<levi::TreeComponent<EvaluableT>>& expandedExpression, const std::vector<size_t>& generics,
+                        const levi::TreeSchedule& schedule, levi::ThreadPool& pool) {
+
+    for (size_t generic : generics) {
+        expandedExpression[generic].valueData = expandedExpression[generic].partialExpression.evaluate().data(); //generics are always evaluated serially
+    }
+
+    for (size_t l = 0; l < schedule.levels.size(); ++l) {
+        const std::vector<size_t>& level = schedule.levels[l];
+
+        if (schedule.parallelLevels[l]) {
+            pool.parallelFor(level.size(), [&expandedExpression, &level](size_t i){levi::evaluateTreeComponent(expandedExpression, level[i]);});
+        } else {
+            for (size_t component : level) {
+                levi::evaluateTreeComponent(expandedExpression, component);
+            }
+        }
+    }
 }
 
 #endif // LEVI_TREEEXPANDER_H
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+ * Authors: Stefano Dafarra
+ * CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+ *
+ */
+#ifndef LEVI_AHEADOFTIMEEXPRESSIONS_H
+#define LEVI_AHEADOFTIMEEXPRESSIONS_H
+
+#include <levi/levi.h>
+
+//Expressions compiled both by AheadOfTimeGenerator and AheadOfTimeTest. They have to be generated in the same way.
+struct AheadOfTimeExpressions {
+    levi::Variable quaternion, x;
+    levi::Expression rotation, chain;
+
+    AheadOfTimeExpressions()
+        : quaternion(4, "q")
+        , x(3, "x")
+    {
+        levi::Expression normalizedQuaternion = quaternion / (quaternion.transpose() * quaternion).pow(0.5);
+        levi::Expression twoSkewQuaternion = 2.0 * normalizedQuaternion.block(1, 0, 3, 1).skew();
+
+        rotation = levi::Identity(3, 3) + normalizedQuaternion(0, 0) * twoSkewQuaternion + 0.5 * twoSkewQuaternion * twoSkewQuaternion;
+
+        chain = rotation * x;
+        for (size_t i = 0; i < 3; ++i) {
+            chain = rotation * chain + rotation.transpose() * x;
+        }
+    }
+
+    std::vector<levi::Expression> compile() const {
+        std::vector<levi::Expression> compiled;
+        compiled.push_back(rotation.compile("AheadOfTimeRotation"));
+
+        levi::setScalarizationMaximumSize(0);
+        levi::setKernelPartMaximumSize(100);
+        compiled.push_back(chain.compile("AheadOfTimeChain"));
+        levi::setKernelPartMaximumSize(100000);
+        levi::setScalarizationMaximumSize(16);
+
+        return compiled;
+    }
+};
+
+#endif // LEVI_AHEADOFTIMEEXPRESSIONS_H
@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+ * Authors: Stefano Dafarra
+ * CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+ *
+ */
+
+#include "AheadOfTimeExpressions.h"
+#include <iostream>
+
+//Writes the sources of the expressions in AheadOfTimeExpressions.h in the directory passed as first argument
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <output directory>" << std::endl;
+        return 1;
+    }
+
+    levi::setCompilationBackend(levi::CompilationBackend::SourcesOnly);
+    levi::setGeneratedSourcesDirectory(argv[1]);
+
+    AheadOfTimeExpressions expressions;
+    expressions.compile();
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+ * Authors: Stefano Dafarra
+ * CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+ *
+ */
+
+#include "AheadOfTimeExpressions.h"
+#include <iostream>
+
+int main() {
+    using namespace levi;
+
+    AheadOfTimeExpressions expressions;
+
+    //The kernels have been generated by AheadOfTimeGenerator and linked in this executable, nothing is built
+    std::vector<Expression> compiled = expressions.compile();
+
+    for (Expression& expression : compiled) {
+        auto evaluable = std::dynamic_pointer_cast<AutogeneratedEvaluable<Evaluable<Eigen::MatrixXd>>>(expression.evaluable().lock());
+        assert(evaluable && evaluable->isLinked());
+        levi::unused(evaluable);
+    }
+
+    expressions.quaternion = Eigen::Vector4d(0.5, -0.1, 0.7, 0.3);
+    expressions.x = Eigen::Vector3d(1.0, -2.0, 3.0);
+
+    assert((compiled[0].evaluate() - expressions.rotation.evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+    assert((compiled[1].evaluate() - expressions.chain.evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+
+    //An expression with the same name but different code is not taken from the registry
+    setCompilationBackend(CompilationBackend::SourcesOnly);
+    setGeneratedSourcesDirectory(zz::os::current_working_directory() + "/AheadOfTimeMismatch");
+    Expression different = (expressions.rotation * 2.0).compile("AheadOfTimeRotation");
+    auto differentEvaluable = std::dynamic_pointer_cast<AutogeneratedEvaluable<Evaluable<Eigen::MatrixXd>>>(different.evaluable().lock());
+    assert(differentEvaluable && !differentEvaluable->isLinked());
+    levi::unused(differentEvaluable);
+    assert((different.evaluate() - 2.0 * expressions.rotation.evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+ * Authors: Stefano Dafarra
+ * CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+ *
+ */
+
+
+#include <levi/levi.h>
+#include <iostream>
+#include <chrono>
+
+using namespace levi;
+
+//Builds a layered graph. Each layer mixes neighbouring elements of the previous one.
+std::vector<Expression> buildLayers(const std::vector<Expression>& inputs, size_t depth) {
+    std::vector<Expression> layer = inputs, nextLayer(inputs.size());
+    size_t width = inputs.size();
+
+    for (size_t level = 0; level < depth; ++level) {
+        for (size_t i = 0; i < width; ++i) {
+            nextLayer[i] = layer[i] * layer[(i + 1) % width] + layer[i];
+        }
+        layer.swap(nextLayer);
+    }
+
+    return layer;
+}
+
+//Sums the expressions pairwise, so that the depth of the result grows only logarithmically
+Expression sumAll(std::vector<Expression> addends) {
+    while (addends.size() > 1) {
+        std::vector<Expression> sums;
+        for (size_t i = 0; i + 1 < addends.size(); i += 2) {
+            sums.push_back(addends[i] + addends[i + 1]);
+        }
+        if (addends.size() % 2) {
+            sums.push_back(addends.back());
+        }
+        addends.swap(sums);
+    }
+    return addends.front();
+}
+
+int main() {
+
+    const size_t depth = 3;
+
+    for (size_t width : {100ul, 1000ul, 10000ul, 100000ul}) {
+
+        std::vector<Expression> inputs(width);
+        for (size_t i = 0; i < width; ++i) {
+            inputs[i] = Variable(1, "x" + std::to_string(i));
+        }
+
+        Expression output = sumAll(buildLayers(inputs, depth));
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        AutogeneratedHelper<DefaultEvaluable> helper({output}, "codeGenerationScaling");
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        size_t codeSize = helper.getTemporariesDeclaration().size() + helper.getFinalExpressions()[0].str().size();
+
+        std::cout << "Width: " << width << ", generated characters: " << codeSize << ". Elapsed time ms (code generation): "
+                  << (std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()/1000.0) << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+ * Authors: Stefano Dafarra
+ * CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+ *
+ */
+
+
+#include <levi/levi.h>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+int main() {
+    using namespace levi;
+
+    const Eigen::Index numberOfPoints = 50;
+    const size_t iterations = 20000;
+
+    Variable quaternion(4, "q");
+    Mutable points(3, numberOfPoints, "points");
+
+    Expression normalizedQuaternion = quaternion / (quaternion.transpose() * quaternion).pow(0.5);
+    Expression skewQuaternion = normalizedQuaternion.block(1, 0, 3, 1).skew();
+    Expression rotation = Identity(3, 3) + 2.0 * normalizedQuaternion(0, 0) * skewQuaternion + 2.0 * skewQuaternion * skewQuaternion;
+    Expression rotatedPoints = rotation * points + rotation.transpose() * points;
+
+    Eigen::MatrixXd pointsValue = Eigen::MatrixXd::Random(3, numberOfPoints);
+    points = pointsValue;
+
+    std::vector<std::pair<std::string, CompileOptions>> profiles(6);
+    profiles[0].first = "default";
+    profiles[1].first = "O2";
+    profiles[1].second.optimizationLevel = 2;
+    profiles[2].first = "native";
+    profiles[2].second.architecture = "native";
+    profiles[3].first = "native, fma";
+    profiles[3].second = profiles[2].second;
+    profiles[3].second.fusedMultiplyAdd = true;
+    profiles[4].first = "native, fma, fast-math";
+    profiles[4].second = profiles[3].second;
+    profiles[4].second.fastMath = true;
+    profiles[5].first = "native, lto";
+    profiles[5].second = profiles[2].second;
+    profiles[5].second.linkTimeOptimization = true;
+
+    std::vector<Eigen::Vector4d> quaternionValues(100);
+    std::vector<Eigen::MatrixXd> expectedValues(quaternionValues.size());
+    for (size_t i = 0; i < quaternionValues.size(); ++i) {
+        quaternionValues[i] = Eigen::Vector4d::Random();
+        quaternion = quaternionValues[i];
+        expectedValues[i] = rotatedPoints.evaluate();
+    }
+
+    for (auto& profile : profiles) {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        Expression compiled = rotatedPoints.compile("profilesBenchmark", profile.second);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        double compilationTime = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()/1000.0;
+
+        for (size_t i = 0; i < quaternionValues.size(); ++i) {
+            quaternion = quaternionValues[i];
+            assert((compiled.evaluate() - expectedValues[i]).cwiseAbs().maxCoeff() < 1e-8);
+        }
+
+        begin = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            quaternion = quaternionValues[i % quaternionValues.size()];
+            compiled.evaluate();
+        }
+        end = std::chrono::steady_clock::now();
+
+        std::cout << std::setw(25) << profile.first << " (flags: " << profile.second.flags() << "). Compilation ms: " << compilationTime
+                  << ". Evaluation us: " << (std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()/1000.0/iterations) << std::endl;
+    }
+
+    return 0;
+}
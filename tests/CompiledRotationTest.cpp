@@ -86,6 +86,42 @@ int main() {
 
     assert(compiled.evaluate() == rotation.evaluate());
 
+    levi::setScalarizationMaximumSize(0); //Generate Eigen code instead of the scalarized one
+    auto compiledEigen = rotation.compile("EigenRotation");
+    levi::setScalarizationMaximumSize(16);
+
+    assert((compiledEigen.evaluate() - rotation.evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+
+    //-------------------------Validation of the batched evaluation
+
+    Expression batchExpression = normalizedQuaternion.block<3,1>(1,0) * x.transpose() + normalizedQuaternion(0,0) * FixedSizeIdentity<3,3>();
+    auto batchScalarized = batchExpression.compile("BatchScalarized");
+    levi::setScalarizationMaximumSize(0);
+    auto batchEigen = batchExpression.compile("BatchEigen");
+    levi::setScalarizationMaximumSize(16);
+
+    const size_t batchSize = 5;
+    Eigen::MatrixXd batchInputs = Eigen::MatrixXd::Random(7, batchSize);
+    for (Expression& compiledBatch : std::vector<Expression>({batchScalarized, batchEigen})) {
+        auto batchEvaluable = std::dynamic_pointer_cast<AutogeneratedEvaluable<Evaluable<Eigen::MatrixXd>>>(compiledBatch.evaluable().lock());
+        assert(batchEvaluable && (batchEvaluable->batchInputs().size() == 2));
+
+        Eigen::MatrixXd batchOutputs(9, batchSize);
+        batchEvaluable->evaluateBatch(batchInputs.data(), batchOutputs.data(), batchSize);
+
+        for (size_t sample = 0; sample < batchSize; ++sample) {
+            for (const auto& input : batchEvaluable->batchInputs()) {
+                if (input.name == "q") {
+                    quaternion = batchInputs.col(sample).segment<4>(input.offset);
+                } else {
+                    x = batchInputs.col(sample).segment<3>(input.offset);
+                }
+            }
+            Eigen::MatrixXd expected = batchExpression.evaluate();
+            assert((Eigen::Map<Eigen::Matrix3d>(batchOutputs.col(sample).data()) - expected).cwiseAbs().maxCoeff() < 1e-10);
+            levi::unused(expected);
+        }
+    }
 
     //-------------------------Validation of first derivative
 
@@ -233,5 +269,126 @@ int main() {
         assert((outputMultiSqueeze[expression.first] - doubleDerivativeValue).cwiseAbs().maxCoeff() < 1e-10);
     }
 
+    //-------------------------Validation of the compilation cache
+
+    levi::setCompilationCacheDirectory(zz::os::current_working_directory() + "/CompilationCache");
+
+    begin = std::chrono::steady_clock::now();
+    auto cachedDerivative = rotatedVectorDerivative.compile("cachedDerivative");
+    end= std::chrono::steady_clock::now();
+    std::cout << "Elapsed time ms (compile first derivative, cache): " << (std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()/1000.0) <<std::endl;
+
+    begin = std::chrono::steady_clock::now();
+    auto cachedDerivativeHit = rotatedVectorDerivative.compile("cachedDerivative");
+    end= std::chrono::steady_clock::now();
+    std::cout << "Elapsed time ms (compile first derivative, cache hit): " << (std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()/1000.0) <<std::endl;
+
+    levi::setCompilationCacheDirectory("");
+
+    x = vector;
+    quaternion = quaternionValue;
+    assert((cachedDerivative.evaluate() - derivativeValue).cwiseAbs().maxCoeff() < 1e-10);
+    assert((cachedDerivativeHit.evaluate() - derivativeValue).cwiseAbs().maxCoeff() < 1e-10);
+
+    //-------------------------Validation of the value and the derivatives compiled in a single kernel
+
+    auto fusedDerivatives = rotatedVector.compileWithDerivatives({quaternion.evaluable().lock(), x.evaluable().lock()}, "fusedDerivatives");
+    quaternion = quaternionValue;
+    x = vector;
+    const DefaultMultipleExpressionsOutputMap& fusedValues = fusedDerivatives->evaluate();
+    assert((fusedValues.at("value") - rotatedVector.evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+    assert((fusedValues.at("q") - derivativeValue).cwiseAbs().maxCoeff() < 1e-10);
+    assert((fusedValues.at("x") - rotation.evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+
+    //-------------------------Validation of the gradients generated with the reverse mode
+
+    Expression distance = normalizedQuaternion.block<3,1>(1,0) - x;
+    Expression cost = distance.transpose() * distance + x.transpose() * normalizedQuaternion.block<3,1>(1,0) / (x.transpose() * x);
+    auto costGradientQ = cost.compileGradient(quaternion.evaluable().lock(), "costGradientQ");
+    auto costGradientX = cost.compileGradient(x.evaluable().lock(), "costGradientX");
+    assert(costGradientQ.evaluable().lock()->isReverseMode() && costGradientX.evaluable().lock()->isReverseMode());
+    quaternion = quaternionValue;
+    x = vector;
+    assert((costGradientQ.evaluate() - cost.getColumnDerivative(0, quaternion).evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+    assert((costGradientX.evaluate() - cost.getColumnDerivative(0, x).evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+
+    Expression rotatedCost = rotatedVector.transpose() * rotatedVector;
+    auto rotatedCostGradient = rotatedCost.compileGradient(quaternion.evaluable().lock(), "rotatedCostGradient");
+    assert(!rotatedCostGradient.evaluable().lock()->isReverseMode()); //The skew matrix depends on the quaternion
+    assert((rotatedCostGradient.evaluate() - rotatedCost.getColumnDerivative(0, quaternion).evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+
+    //-------------------------Validation of several expressions built in a single library
+
+    DefaultCompilationUnit unit("RotationUnit");
+    Expression unitRotation = unit.add(rotation, "unitRotation");
+    Expression unitDerivative = unit.add(rotatedVectorDerivative, "unitDerivative");
+    Expression unitBatch = unit.add(batchExpression, "unitBatch");
+    quaternion = quaternionValue;
+    x = vector;
+    assert((unitDerivative.evaluate() - derivativeValue).cwiseAbs().maxCoeff() < 1e-10); //Squeezed until the unit is compiled
+
+    bool unitCompiled = unit.compile();
+    assert(unitCompiled);
+    levi::unused(unitCompiled);
+    assert(std::dynamic_pointer_cast<AutogeneratedEvaluable<Evaluable<Eigen::MatrixXd>>>(unitDerivative.evaluable().lock())->isReady());
+    quaternion = quaternionValue;
+    x = vector;
+    assert((unitRotation.evaluate() - rotation.evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+    assert((unitDerivative.evaluate() - derivativeValue).cwiseAbs().maxCoeff() < 1e-10);
+    assert((unitBatch.evaluate() - batchExpression.evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+
+    //-------------------------Validation of kernels split in several sources
+
+    Expression chain = rotation;
+    for (size_t i = 0; i < 4; ++i) {
+        chain = chain * rotation + rotation.transpose() * chain;
+    }
+
+    levi::setScalarizationMaximumSize(0);
+    levi::setKernelPartMaximumSize(100);
+    auto splitChain = chain.compile("SplitChain");
+    levi::setKernelPartMaximumSize(100000);
+    levi::setScalarizationMaximumSize(16);
+
+    assert(zz::os::is_file(zz::os::current_working_directory() + "/SplitChain/sourcePart1.cpp"));
+    quaternion = quaternionValue;
+    assert((splitChain.evaluate() - chain.evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+
+    //-------------------------Validation of the asynchronous compilation
+
+    begin = std::chrono::steady_clock::now();
+    auto asyncDerivative = rotatedVectorDerivative.compileAsync("asyncDerivative");
+    end= std::chrono::steady_clock::now();
+    std::cout << "Elapsed time ms (compile first derivative, asynchronous): " << (std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()/1000.0) <<std::endl;
+
+    auto asyncEvaluable = asyncDerivative.evaluable().lock();
+    assert((asyncDerivative.evaluate() - derivativeValue).cwiseAbs().maxCoeff() < 1e-10);
+
+    while (!asyncEvaluable->waitUntilReady(std::chrono::milliseconds(100))) {
+        std::cout << "Waiting for the asynchronous compilation.." << std::endl;
+    }
+    assert(asyncEvaluable->isReady());
+
+    x = vector;
+    assert((asyncDerivative.evaluate() - derivativeValue).cwiseAbs().maxCoeff() < 1e-10);
+
+    //-------------------------Validation of constants, zeros, identities and concatenations in the generated code
+
+    Constant constantMatrix(Eigen::Matrix3d::Random(), "K");
+    Expression top = Expression::Horzcat(constantMatrix * x, rotation, "top");
+    Expression bottom = Expression::Horzcat(Null(3, 1), Identity(3, 3), "bottom");
+    Expression stacked = Expression::Vertcat(top, -0.5 * bottom + top, "stacked");
+
+    x = vector;
+    quaternion = quaternionValue;
+    Eigen::MatrixXd stackedValue = stacked.evaluate();
+
+    for (Eigen::Index maximumSize : {0, 32}) { //Eigen and scalarized code
+        levi::setScalarizationMaximumSize(maximumSize);
+        auto compiledStacked = stacked.compile("Stacked" + std::to_string(maximumSize));
+        assert((compiledStacked.evaluate() - stackedValue).cwiseAbs().maxCoeff() < 1e-10);
+    }
+    levi::setScalarizationMaximumSize(16);
+
     return 0;
     }
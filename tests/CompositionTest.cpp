@@ -123,5 +123,31 @@ int main() {
     Null zero(3,3);
     Expression testZero = zero;
 
+    //Patterns evaluated with fused kernels when squeezed
+    Expression fusedA = x * y.transpose(), fusedB = y * x.transpose() + fusedA;
+    y = Eigen::Vector3d(0.5, 4.0, -1.0);
+    std::vector<Expression> fusedPatterns = {fusedA * y + x, x - fusedA * y, fusedA.transpose() * fusedB, -(fusedA * fusedB) + fusedB,
+                                             y(1,0) * fusedB + fusedA, fusedB * y(1,0) - fusedA};
+    for (Expression& pattern : fusedPatterns) {
+        assert((pattern.squeeze("fusedTest").evaluate() - pattern.evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+    }
+
+    //Accessors and concatenations evaluated in place when squeezed
+    Expression nested = Expression::Horzcat(Expression::Vertcat(fusedA * y, fusedA.row(0).transpose(), "top"),
+                                            Expression::Vertcat(x + y, y.transpose().transpose(), "bottom"), "nested");
+    std::vector<Expression> inPlacePatterns = {nested, nested.row(4) * nested.block(0, 0, 2, 2), nested(5, 1) * nested.transpose(),
+                                               y.transpose() * fusedA + x.transpose()};
+    for (Expression& pattern : inPlacePatterns) {
+        assert((pattern.squeeze("inPlaceTest").evaluate() - pattern.evaluate()).cwiseAbs().maxCoeff() < 1e-10);
+    }
+
+    //Powers strength reduced in the same way when evaluated and when squeezed
+    z = 1.3;
+    for (double exponent : {2.0, 3.0, 4.0, -1.0, -2.0, 0.5, -0.5, 0.0, 1.0, 1.5, 5.0}) {
+        ScalarExpression zPower = z.pow(exponent);
+        assert(std::abs(zPower.evaluate() - std::pow(1.3, exponent)) < 1e-14);
+        assert(zPower.squeeze("powerTest").evaluate()(0,0) == zPower.evaluate());
+    }
+
     return 0;
 }
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+ * Authors: Stefano Dafarra
+ * CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+ *
+ */
+
+
+#include <levi/levi.h>
+#include <iostream>
+#include <chrono>
+
+using namespace levi;
+
+//Builds a layered graph. Each layer mixes neighbouring elements of the previous one.
+std::vector<Expression> buildLayers(const std::vector<Expression>& inputs, size_t depth) {
+    std::vector<Expression> layer = inputs, nextLayer(inputs.size());
+    size_t width = inputs.size();
+
+    for (size_t level = 0; level < depth; ++level) {
+        for (size_t i = 0; i < width; ++i) {
+            nextLayer[i] = layer[i] * layer[(i + 1) % width] + layer[i];
+        }
+        layer.swap(nextLayer);
+    }
+
+    return layer;
+}
+
+int main() {
+
+    const size_t depth = 3;
+    const size_t nodesPerElement = 2 * depth + 1; //one variable, then a product and a sum per level
+
+    for (size_t targetNodes : {1000ul, 10000ul, 100000ul, 1000000ul}) {
+        size_t width = targetNodes / nodesPerElement;
+
+        std::vector<Expression> inputs(width);
+        for (size_t i = 0; i < width; ++i) {
+            inputs[i] = Variable(1, "x" + std::to_string(i)); //a single big variable would store a dense derivative of size width x width
+        }
+
+        std::vector<Expression> outputs = buildLayers(inputs, depth);
+        std::vector<Expression> duplicatedOutputs = buildLayers(inputs, 1); //same structure of the first layer, different evaluables
+
+        std::vector<TreeComponent<DefaultEvaluable>> expandedExpression;
+        std::vector<size_t> generics;
+        AddedExpressions alreadyAdded;
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for (const Expression& output : outputs) {
+            expandTree(output, true, expandedExpression, generics, alreadyAdded);
+        }
+        for (const Expression& output : duplicatedOutputs) {
+            expandTree(output, true, expandedExpression, generics, alreadyAdded);
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        assert(expandedExpression.size() == width * nodesPerElement);
+        assert(generics.size() == width);
+
+        std::cout << "Expanded nodes: " << expandedExpression.size() << " (visited evaluables: " << alreadyAdded.evaluables.size()
+                  << "). Elapsed time ms (expandTree): " << (std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()/1000.0) << std::endl;
+    }
+
+    return 0;
+}
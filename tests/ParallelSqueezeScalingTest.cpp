@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2019 Fondazione Istituto Italiano di Tecnologia
+ * Authors: Stefano Dafarra
+ * CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+ *
+ */
+
+
+#include <levi/levi.h>
+#include <iostream>
+#include <chrono>
+#include <thread>
+
+using namespace levi;
+
+int main() {
+
+    const size_t width = 1000;
+    const size_t depth = 5;
+    const size_t dimension = 10;
+    const size_t repetitions = 20;
+
+    std::vector<Expression> layer(width);
+    for (size_t i = 0; i < width; ++i) {
+        Variable v(dimension, "x" + std::to_string(i));
+        v = Eigen::VectorXd::Random(dimension) / std::sqrt(static_cast<double>(dimension));
+        layer[i] = v * v.transpose();
+    }
+
+    //Each layer mixes neighbouring elements of the previous one, so that the nodes of a layer are independent
+    for (size_t level = 0; level < depth; ++level) {
+        std::vector<Expression> nextLayer(width);
+        for (size_t i = 0; i < width; ++i) {
+            nextLayer[i] = layer[i] * layer[(i + 1) % width] - layer[i];
+        }
+        layer.swap(nextLayer);
+    }
+
+    MultipleExpressionsMap<Eigen::MatrixXd> outputs;
+    for (size_t i = 0; i < width; ++i) {
+        outputs["y" + std::to_string(i)] = layer[i];
+    }
+
+    std::cout << "Available hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    DefaultMultipleSqueezedOutputPointer serial = SqueezeMultipleExpressions(outputs);
+    DefaultMultipleExpressionsOutputMap expected = serial->evaluate();
+    double serialTime = 0;
+
+    for (size_t threads : {1ul, 2ul, 4ul, 8ul, 16ul}) {
+        DefaultMultipleSqueezedOutputPointer squeezed = SqueezeMultipleExpressions(outputs, threads);
+        squeezed->evaluate();
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < repetitions; ++r) {
+            squeezed->evaluate();
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        double elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()/(1000.0 * repetitions);
+        if (threads == 1) {
+            serialTime = elapsed;
+        }
+
+        for (auto& output : squeezed->evaluate()) {
+            assert((output.second - expected.at(output.first)).cwiseAbs().maxCoeff() < 1e-10);
+        }
+
+        std::cout << "Threads: " << threads << ". Elapsed time ms (evaluate): " << elapsed << " (speedup " << serialTime / elapsed << ")" << std::endl;
+    }
+
+    return 0;
+}